@@ -0,0 +1,91 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+
+#if defined(__linux__)
+# define WALKER_HAVE_PERF_EVENT 1
+# include <linux/perf_event.h>
+# include <sys/ioctl.h>
+# include <sys/syscall.h>
+# include <unistd.h>
+#endif
+
+// Hardware counters (CPU cycles, last-level cache misses and data TLB
+// misses) of the calling thread read through perf_event_open(2).  If the
+// counters are not available (non-Linux, no permission, virtual machine,
+// ...), available() returns false and all the values are zero.  The data
+// TLB counter is optional: if only it is missing, dtlb_misses() is zero.
+
+class perf_event {
+public:
+  perf_event() : fd_cycles_(-1), fd_misses_(-1), fd_dtlb_(-1) {
+#ifdef WALKER_HAVE_PERF_EVENT
+    fd_cycles_ = open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, -1);
+    if (fd_cycles_ >= 0)
+      fd_misses_ = open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES, fd_cycles_);
+    if (fd_misses_ < 0) close();
+    if (fd_cycles_ >= 0)
+      fd_dtlb_ = open(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_DTLB |
+        (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16), fd_cycles_);
+#endif
+  }
+  perf_event(const perf_event&) = delete;
+  perf_event& operator=(const perf_event&) = delete;
+  ~perf_event() { close(); }
+
+  bool available() const { return fd_cycles_ >= 0; }
+
+  void start() {
+#ifdef WALKER_HAVE_PERF_EVENT
+    if (!available()) return;
+    ioctl(fd_cycles_, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(fd_cycles_, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#endif
+  }
+  void stop() {
+#ifdef WALKER_HAVE_PERF_EVENT
+    if (!available()) return;
+    ioctl(fd_cycles_, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+#endif
+  }
+
+  std::uint64_t cycles() const { return read(fd_cycles_); }
+  std::uint64_t llc_misses() const { return read(fd_misses_); }
+  std::uint64_t dtlb_misses() const { return read(fd_dtlb_); }
+
+private:
+#ifdef WALKER_HAVE_PERF_EVENT
+  static int open(std::uint32_t type, std::uint64_t config, int group) {
+    struct perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.type = type;
+    attr.size = sizeof(attr);
+    attr.config = config;
+    attr.disabled = (group < 0) ? 1 : 0;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return int(syscall(__NR_perf_event_open, &attr, 0, -1, group, 0));
+  }
+#endif
+  std::uint64_t read(int fd) const {
+    std::uint64_t value = 0;
+#ifdef WALKER_HAVE_PERF_EVENT
+    if (fd >= 0 && ::read(fd, &value, sizeof(value)) != sizeof(value)) value = 0;
+#else
+    (void)fd;
+#endif
+    return value;
+  }
+  void close() {
+#ifdef WALKER_HAVE_PERF_EVENT
+    if (fd_dtlb_ >= 0) ::close(fd_dtlb_);
+    if (fd_misses_ >= 0) ::close(fd_misses_);
+    if (fd_cycles_ >= 0) ::close(fd_cycles_);
+#endif
+    fd_cycles_ = fd_misses_ = fd_dtlb_ = -1;
+  }
+
+  int fd_cycles_;
+  int fd_misses_;
+  int fd_dtlb_;
+};
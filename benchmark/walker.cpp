@@ -0,0 +1,955 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <standards/timer.hpp>
+#include "walker/allocator.hpp"
+#include "walker/masked_sampling.hpp"
+#include "walker/multinomial_sampling.hpp"
+#include "walker/philox.hpp"
+#include "walker/random_choice.hpp"
+#include "walker/random_choice_bank.hpp"
+#include "walker/subset_sampling.hpp"
+#include "walker/sum_tree_sampling.hpp"
+#include "walker/tower_sampling.hpp"
+#include "walker/xoshiro.hpp"
+#if __cplusplus >= 201703L
+# include "walker/static_random_choice.hpp"
+#endif
+#include "perf_event.hpp"
+
+// Benchmark driver for all the samplers in walker/ and
+// std::discrete_distribution.  For each engine, weight distribution,
+// number of bins (e.g. 1e10 with mt19937_64, for which random_choice has
+// 64-bit indices), number of threads and sampler, it reports construction
+// time, samples/sec (mean and standard deviation over repeats),
+// ns/sample, table size in bytes (0 if not reported), the growth of the
+// memory of the process on transparent huge pages by the construction
+// (AnonHugePages in kB, Linux only), and optionally CPU cycles, LLC misses
+// and data TLB misses per sample, in CSV or JSON.  The engines are
+// mt19937, mt19937_64, philox4x32 and xoshiro256pp_simd, the raw words/sec
+// of which are given by the engine and engine_fill_<isa> cases.
+//
+// With more than one thread, the sampler is built by that many threads if
+// it supports parallel construction, and is shared read-only by the
+// threads, each of which draws with its own engine; samples/sec is then
+// the aggregate rate.  Samplers with mutable state run with one thread
+// only.  A "sample" is one call of the case, i.e. a subset of k elements
+// for subset_*, a histogram of m draws for multinomial_*, a draw
+// (preceded by an update every `param' draws) for *_update, and a
+// rebuild and a draw for random_choice_construct and *_rebuild*, and a
+// forbid() and an allow() of an allowed bin for masked_update.  The
+// random_choice_bank and random_choice_vector cases split the weights
+// into n/param tables of param bins each, and draw from a random table
+// (as in heat-bath updates of a lattice model).  `param' is the parameter
+// of the case (k/n, m/n, draws per update, guide buckets per bin, log2 of
+// the block size, masked fraction of bins, bins per table), or empty.
+
+struct options {
+  double duration = 1;
+  int repeat = 5;
+  bool json = false;
+  bool counters = false;
+  std::vector<std::string> samplers;
+  std::vector<std::string> engines = { "mt19937" };
+  std::vector<std::string> weights = { "uniform", "exponential", "power-law", "one-hot", "many-zeros" };
+  std::vector<unsigned int> threads = { 1 };
+  std::vector<double> subset = { 0.001, 0.01, 0.1, 0.5, 0.9 };   // k/n
+  std::vector<double> multinomial = { 0.1, 1, 10, 100 };          // m/n
+  std::vector<double> update = { 1, 2, 5, 10 };                   // draws per update
+  std::vector<double> masked = { 0, 0.1, 0.3, 0.5, 0.7, 0.9, 0.99 }; // masked fraction of bins
+  std::vector<double> bank = { 4, 16, 64 };                       // bins per table
+  std::vector<std::size_t> sizes;
+};
+
+struct result {
+  std::string sampler;
+  std::string engine;
+  std::string weights;
+  std::size_t n;
+  unsigned int threads;
+  double param; // NaN if none
+  double build_sec;
+  double samples_per_sec;
+  double stddev;
+  double ns_per_sample;
+  std::size_t table_bytes;
+  long huge_page_kb;
+  double cycles;      // per sample (0 if not measured)
+  double llc_misses;  // per sample (0 if not measured)
+  double dtlb_misses; // per sample (0 if not measured)
+  unsigned int xor_sum;
+};
+
+// result of case `sampler' with parameter `param' in the context of `proto'
+result named(result const& proto, std::string const& sampler,
+             double param = std::numeric_limits<double>::quiet_NaN()) {
+  result res = proto;
+  res.sampler = sampler;
+  res.param = param;
+  return res;
+}
+
+// memory of the process on transparent huge pages in kB (0 if unknown)
+long anon_huge_pages() {
+  std::ifstream in("/proc/self/smaps_rollup");
+  std::string key;
+  long kb = 0;
+  while (in >> key) {
+    if (key == "AnonHugePages:") {
+      in >> kb;
+      return kb;
+    }
+    in.ignore(1024, '\n');
+  }
+  return 0;
+}
+
+template<class Engine>
+std::vector<double> generate_weights(std::string const& name, std::size_t n, Engine& eng) {
+  std::uniform_real_distribution<> dist;
+  std::vector<double> weights(n, 0);
+  if (name == "uniform") {
+    for (auto& w : weights) w = dist(eng);
+  } else if (name == "exponential") {
+    for (std::size_t i = 0; i < n; ++i) weights[i] = std::exp(-10.0 * i / n);
+  } else if (name == "power-law") {
+    for (std::size_t i = 0; i < n; ++i) weights[i] = std::pow(i + 1.0, -1.5);
+  } else if (name == "one-hot") {
+    weights[n / 2] = 1;
+  } else if (name == "many-zeros") {
+    // 90% of the bins have zero weight
+    for (auto& w : weights) w = (dist(eng) < 0.1) ? dist(eng) : 0;
+    weights[n - 1] = 1;
+  } else {
+    std::cerr << "Error: unknown weights " << name << std::endl;
+    std::exit(127);
+  }
+  return weights;
+}
+
+// xor of `loop' draws by each of the engines `engs', one thread per engine
+template<class RC, class DRAW, class Engine>
+unsigned int draw_loop(RC& rc, DRAW const& draw, std::vector<Engine>& engs, int loop) {
+  if (engs.size() == 1) {
+    unsigned int x = 0;
+    for (int p = 0; p < loop; ++p) x ^= draw(rc, engs[0]);
+    return x;
+  }
+  std::vector<unsigned int> xs(engs.size(), 0);
+  walker::detail::parallel_run(unsigned(engs.size()), [&](unsigned int k) {
+    Engine eng = engs[k];
+    unsigned int x = 0;
+    for (int p = 0; p < loop; ++p) x ^= draw(rc, eng);
+    engs[k] = eng;
+    xs[k] = x;
+  });
+  unsigned int x = 0;
+  for (auto y : xs) x ^= y;
+  return x;
+}
+
+// `build(weights)' returns a sampler, `draw(sampler, eng)' returns a
+// sample, and `bytes(sampler)' returns the size of its table.  `res'
+// gives the sampler name and the context of the case.
+template<class Engine, class BUILD, class DRAW, class BYTES>
+void bench(options const& opt, result res, std::vector<double> const& weights,
+           BUILD const& build, DRAW const& draw, BYTES const& bytes, std::vector<result>& results) {
+  if (!opt.samplers.empty() &&
+      std::find(opt.samplers.begin(), opt.samplers.end(), res.sampler) == opt.samplers.end())
+    return;
+  std::vector<Engine> engs;
+  for (unsigned int k = 0; k < res.threads; ++k) engs.emplace_back(29411 + k);
+  res.xor_sum = 0;
+
+  // construction time (the case is skipped if the sampler can not be
+  // built, e.g. for N beyond the range of its index type)
+  try {
+    int loop = 1;
+    double elapsed = 0.0;
+    for (; elapsed < 0.1 * opt.duration && loop < (1 << 30); loop *= 2) {
+      standards::timer t;
+      for (int p = 0; p < loop; ++p) res.xor_sum ^= bytes(build(weights));
+      elapsed = t.elapsed();
+    }
+    res.build_sec = elapsed / (loop / 2);
+  } catch (std::exception const& e) {
+    std::cerr << "Warning: " << res.sampler << " skipped for n = " << res.n << ": " << e.what()
+              << std::endl;
+    return;
+  }
+
+  long huge_kb = anon_huge_pages();
+  auto rc = build(weights);
+  res.huge_page_kb = anon_huge_pages() - huge_kb;
+  res.table_bytes = bytes(rc);
+
+  // number of samples per repeat
+  int loop = 1;
+  double elapsed = 0.0;
+  for (; elapsed < opt.duration && loop < (1 << 30); loop *= 2) {
+    standards::timer t;
+    res.xor_sum ^= draw_loop(rc, draw, engs, loop);
+    elapsed = t.elapsed();
+  }
+  loop /= 2;
+
+  // repeats (the counters see the calling thread only)
+  perf_event counter;
+  bool counting = opt.counters && res.threads == 1 && counter.available();
+  double sum = 0, sum2 = 0;
+  std::uint64_t cycles = 0, misses = 0, dtlb = 0;
+  for (int k = 0; k < opt.repeat; ++k) {
+    if (counting) counter.start();
+    standards::timer t;
+    res.xor_sum ^= draw_loop(rc, draw, engs, loop);
+    double e = t.elapsed();
+    if (counting) {
+      counter.stop();
+      cycles += counter.cycles();
+      misses += counter.llc_misses();
+      dtlb += counter.dtlb_misses();
+    }
+    double perf = double(res.threads) * loop / e;
+    sum += perf;
+    sum2 += perf * perf;
+  }
+  const double samples = double(res.threads) * loop * opt.repeat;
+  res.samples_per_sec = sum / opt.repeat;
+  res.stddev = (opt.repeat > 1) ?
+    std::sqrt(std::max(0.0, (sum2 - sum * sum / opt.repeat) / (opt.repeat - 1))) : 0;
+  res.ns_per_sample = 1e9 / res.samples_per_sec;
+  res.cycles = counting ? double(cycles) / samples : 0;
+  res.llc_misses = counting ? double(misses) / samples : 0;
+  res.dtlb_misses = counting ? double(dtlb) / samples : 0;
+  results.push_back(res);
+}
+
+template<class RC>
+std::size_t no_table(RC const&) { return 0; }
+
+// samples drawn by generate() in blocks and returned one by one
+template<class RC>
+struct batched {
+  typedef typename RC::result_type result_type;
+  batched(RC const& r) : rc(r), buffer(4096), pos(buffer.size()) {}
+  template<class Engine>
+  result_type operator()(Engine& eng) {
+    if (pos == buffer.size()) {
+      rc.generate(eng, buffer.data(), buffer.data() + buffer.size());
+      pos = 0;
+    }
+    return buffer[pos++];
+  }
+  RC rc;
+  std::vector<result_type> buffer;
+  std::size_t pos;
+};
+
+// words generated by fill() in blocks and returned one by one
+template<class Engine>
+struct filled {
+  typedef typename Engine::result_type result_type;
+  filled() : buffer(4096), pos(buffer.size()) {}
+  result_type operator()(Engine& eng) {
+    if (pos == buffer.size()) {
+      eng.fill(buffer.data(), buffer.data() + buffer.size());
+      pos = 0;
+    }
+    return buffer[pos++];
+  }
+  std::vector<result_type> buffer;
+  std::size_t pos;
+};
+
+// std::upper_bound on the cumulative weights
+struct upper_bound_search {
+  upper_bound_search(std::vector<double> const& weights) {
+    double sum = 0, a = 0;
+    for (auto w : weights) sum += w;
+    for (auto w : weights) accum.push_back(a += w / sum);
+  }
+  template<class Engine>
+  unsigned int operator()(Engine& eng) const {
+    return std::min<std::size_t>(accum.size() - 1,
+      std::upper_bound(accum.begin(), accum.end(), eng()) - accum.begin());
+  }
+  std::vector<double> accum;
+};
+
+// sampler, one weight of which is updated every `draws' draws
+template<class RC>
+struct updated {
+  RC rc;
+  std::vector<double> weights;
+  int draws, count;
+};
+
+// sampler rebuilt for `weights', with a caller-owned work array
+template<class RC>
+struct rebuilt {
+  RC rc;
+  std::vector<double> weights;
+  typename RC::workspace_type work;
+};
+
+// alias table and masked_sampling on it, which masks the first m bins of
+// `order'.  It is not copied, since masked_sampling refers to the table.
+template<class RC>
+struct masked {
+  masked(std::vector<double> const& w, double threshold, std::vector<unsigned int> const& o,
+         std::size_t m) : rc(w), ms(rc, w, threshold), order(o), count(m) {
+    if (std::none_of(order.begin() + m, order.end(), [&](unsigned int i) { return w[i] > 0; }))
+      throw std::range_error("all the weight is masked");
+    ms.forbid(order.begin(), order.begin() + m);
+  }
+  RC rc;
+  walker::masked_sampling<RC> ms;
+  std::vector<unsigned int> const& order;
+  std::size_t count;
+};
+
+// sampler and the buffers for one subset or histogram
+template<class RC, class T>
+struct buffered {
+  RC rc;
+  std::vector<T> buffer;
+  std::vector<unsigned int> subset;
+};
+
+const char* isa_name(walker::detail::simd_isa isa) {
+  switch (isa) {
+  case walker::detail::simd_isa::avx2: return "avx2";
+  case walker::detail::simd_isa::avx512: return "avx512";
+  default: return "scalar";
+  }
+}
+
+// fill() of the engine with each instruction set
+template<class Engine>
+void run_fill(options const& opt, result const& proto, std::vector<double> const& weights,
+              std::vector<result>& results, std::true_type) {
+  const walker::detail::simd_isa best = walker::detail::detect_simd_isa();
+  for (auto isa : { walker::detail::simd_isa::scalar, walker::detail::simd_isa::avx2,
+                    walker::detail::simd_isa::avx512 }) {
+    if (isa > best) continue;
+    walker::detail::simd_level() = isa;
+    bench<Engine>(opt, named(proto, std::string("engine_fill_") + isa_name(isa)), weights,
+      [](std::vector<double> const&) { return filled<Engine>(); },
+      [](filled<Engine>& f, Engine& eng) { return (unsigned int)(f(eng)); },
+      no_table<filled<Engine> >, results);
+  }
+  walker::detail::simd_level() = best;
+}
+template<class Engine>
+void run_fill(options const&, result const&, std::vector<double> const&,
+              std::vector<result>&, std::false_type) {}
+
+// single_draw for 64-bit engines
+template<class Engine>
+void run_engine64(options const& opt, result const& proto, std::vector<double> const& weights,
+                  std::vector<result>& results, std::true_type) {
+  typedef walker::random_choice<Engine> rc_type;
+  bench<Engine>(opt, named(proto, "random_choice_single_draw"), weights,
+    [](std::vector<double> const& w) { return rc_type(w); },
+    [](rc_type const& rc, Engine& eng) { return (unsigned int)(rc.single_draw(eng)); },
+    [](rc_type const& rc) { return rc.table_bytes(); },
+    results);
+}
+template<class Engine>
+void run_engine64(options const&, result const&, std::vector<double> const&,
+                  std::vector<result>&, std::false_type) {}
+
+// compile-time tables for small N, which are built
+// from fixed weights (reported as "fixed"), and runtime tables from the
+// same weights
+#if __cplusplus >= 201703L
+template<std::size_t N>
+constexpr std::array<double, N> static_weights() {
+  std::array<double, N> w{};
+  for (std::size_t i = 0; i < N; ++i) w[i] = 1 + (i * 37) % 11;
+  return w;
+}
+
+template<class Engine, std::size_t N>
+void bench_static(options const& opt, result const& proto, std::vector<result>& results) {
+  static constexpr std::array<double, N> sw = static_weights<N>();
+  static constexpr walker::static_random_choice<N> src(sw);
+  typedef walker::random_choice<Engine> rc_type;
+  result res = proto;
+  res.weights = "fixed";
+  std::vector<double> weights(sw.begin(), sw.end());
+  bench<Engine>(opt, named(res, "static_random_choice"), weights,
+    [](std::vector<double> const&) { return src; },
+    [](walker::static_random_choice<N> const& rc, Engine& eng) { return (unsigned int)(rc(eng)); },
+    [](walker::static_random_choice<N> const& rc) { return sizeof(rc.table()); },
+    results);
+  bench<Engine>(opt, named(res, "static_random_choice_runtime"), weights,
+    [](std::vector<double> const& w) { return rc_type(w); },
+    [](rc_type const& rc, Engine& eng) { return (unsigned int)(rc(eng)); },
+    [](rc_type const& rc) { return rc.table_bytes(); },
+    results);
+}
+
+template<class Engine, std::size_t... Ns>
+void run_static(options const& opt, result const& proto, std::vector<result>& results,
+                std::true_type, std::index_sequence<Ns...>) {
+  ((proto.n == Ns + 2 ? bench_static<Engine, Ns + 2>(opt, proto, results) : void()), ...);
+}
+#endif
+template<class Engine, class SEQ>
+void run_static(options const&, result const&, std::vector<result>&, std::false_type, SEQ) {}
+
+template<class Engine>
+void run(options const& opt, std::string const& ename, std::string const& wname, std::size_t n,
+         unsigned int nthreads, std::vector<result>& results) {
+  std::mt19937 gen(29411);
+  std::vector<double> weights = generate_weights(wname, n, gen);
+  result proto;
+  proto.engine = ename;
+  proto.weights = wname;
+  proto.n = n;
+  proto.threads = nthreads;
+  const bool serial = (nthreads == 1);
+  auto real_draw = [](auto const& rc, Engine& eng) {
+    std::uniform_real_distribution<> dist;
+    auto u01 = [&]() { return dist(eng); };
+    return (unsigned int)(rc(u01));
+  };
+  auto direct_draw = [](auto const& rc, Engine& eng) { return (unsigned int)(rc(eng)); };
+  typedef walker::random_choice<Engine> rc_type;
+
+  // engines (baselines, independent of the weights)
+  bench<Engine>(opt, named(proto, "engine"), weights, [](std::vector<double> const&) { return 0; },
+    [](int, Engine& eng) { return (unsigned int)(eng()); }, no_table<int>, results);
+  bench<Engine>(opt, named(proto, "uniform_real"), weights, [](std::vector<double> const&) { return 0; },
+    [](int, Engine& eng) {
+      return (unsigned int)(std::uniform_real_distribution<>()(eng) * 4294967296.0); },
+    no_table<int>, results);
+  if (serial) run_fill<Engine>(opt, proto, weights, results, walker::detail::has_fill<Engine>());
+
+  // std::discrete_distribution (stores probabilities and accumulated ones)
+  if (serial)
+    bench<Engine>(opt, named(proto, "discrete_distribution"), weights,
+      [](std::vector<double> const& w) { return std::discrete_distribution<>(w.begin(), w.end()); },
+      [](std::discrete_distribution<>& rc, Engine& eng) { return (unsigned int)(rc(eng)); },
+      [](std::discrete_distribution<> const& rc) { return 2 * rc.probabilities().size() * sizeof(double); },
+      results);
+
+  // Walker's alias method, built by fill_ft2009 and by fill_hs2019
+  bench<Engine>(opt, named(proto, "random_choice"), weights,
+    [](std::vector<double> const& w) { return rc_type(w); },
+    direct_draw,
+    [](rc_type const& rc) { return rc.table_bytes(); },
+    results);
+  bench<Engine>(opt, named(proto, "random_choice_hs2019"), weights,
+    [nthreads](std::vector<double> const& w) { return rc_type(w, nthreads); },
+    direct_draw,
+    [](rc_type const& rc) { return rc.table_bytes(); },
+    results);
+  if (serial) {
+    // generate() with each instruction set
+    const walker::detail::simd_isa best = walker::detail::detect_simd_isa();
+    for (auto isa : { walker::detail::simd_isa::scalar, walker::detail::simd_isa::avx2,
+                      walker::detail::simd_isa::avx512 }) {
+      if (isa > best) continue;
+      walker::detail::simd_level() = isa;
+      bench<Engine>(opt, named(proto, std::string("random_choice_batch_") + isa_name(isa)), weights,
+        [](std::vector<double> const& w) { return batched<rc_type>(rc_type(w)); },
+        [](batched<rc_type>& rc, Engine& eng) { return (unsigned int)(rc(eng)); },
+        [](batched<rc_type> const& rc) { return rc.rc.table_bytes(); },
+        results);
+    }
+    walker::detail::simd_level() = best;
+  }
+  run_engine64<Engine>(opt, proto, weights, results, walker::detail::is_engine64<Engine>());
+  bench<Engine>(opt, named(proto, "random_choice_multiply"), weights,
+    [](std::vector<double> const& w) { return walker::detail::random_choice_multiply<>(w); },
+    direct_draw,
+    [](walker::detail::random_choice_multiply<> const& rc) { return rc.table_bytes(); },
+    results);
+  for (int log2_block : { 9, 12 })
+    bench<Engine>(opt, named(proto, "random_choice_blocked", log2_block), weights,
+      [=](std::vector<double> const& w) {
+        return walker::detail::random_choice_blocked<>(w, log2_block, nthreads); },
+      direct_draw,
+      [](walker::detail::random_choice_blocked<> const& rc) { return rc.table_bytes(); },
+      results);
+  bench<Engine>(opt, named(proto, "random_choice_packed"), weights,
+    [](std::vector<double> const& w) { return walker::detail::random_choice_packed<>(w); },
+    real_draw,
+    [](walker::detail::random_choice_packed<> const& rc) { return rc.table_bytes(); },
+    results);
+  if (n - 1 <= 0xffff)
+    bench<Engine>(opt, named(proto, "random_choice_compact_u16"), weights,
+      [](std::vector<double> const& w) { return walker::random_choice_compact<walker::width_u16>(w); },
+      direct_draw,
+      [](walker::random_choice_compact<walker::width_u16> const& rc) { return rc.table_bytes(); },
+      results);
+  bench<Engine>(opt, named(proto, "random_choice_compact_f32"), weights,
+    [](std::vector<double> const& w) { return walker::random_choice_compact<walker::width_f32>(w); },
+    real_draw,
+    [](walker::random_choice_compact<walker::width_f32> const& rc) { return rc.table_bytes(); },
+    results);
+  bench<Engine>(opt, named(proto, "random_choice_compact_f64"), weights,
+    [](std::vector<double> const& w) { return walker::random_choice_compact<walker::width_f64>(w); },
+    real_draw,
+    [](walker::random_choice_compact<walker::width_f64> const& rc) { return rc.table_bytes(); },
+    results);
+  if (serial && wname == opt.weights.front())
+    run_static<Engine>(opt, proto, results,
+      std::integral_constant<bool, __cplusplus >= 201703L>(), std::make_index_sequence<63>());
+
+  // search over the accumulated weights
+  bench<Engine>(opt, named(proto, "random_choice_bsearch"), weights,
+    [](std::vector<double> const& w) { return walker::detail::random_choice_bsearch<>(w); },
+    real_draw,
+    [n](walker::detail::random_choice_bsearch<> const&) { return n * sizeof(double); },
+    results);
+  bench<Engine>(opt, named(proto, "upper_bound"), weights,
+    [](std::vector<double> const& w) { return upper_bound_search(w); },
+    real_draw,
+    [n](upper_bound_search const&) { return n * sizeof(double); },
+    results);
+  bench<Engine>(opt, named(proto, "random_choice_eytzinger"), weights,
+    [](std::vector<double> const& w) { return walker::detail::random_choice_eytzinger<>(w); },
+    real_draw,
+    [n](walker::detail::random_choice_eytzinger<> const&) {
+      return (n + 1) * (sizeof(double) + sizeof(unsigned int)); },
+    results);
+  for (double factor : { 1, 4 })
+    bench<Engine>(opt, named(proto, "random_choice_guide", factor), weights,
+      [factor](std::vector<double> const& w) { return walker::detail::random_choice_guide<>(w, factor); },
+      real_draw,
+      [](walker::detail::random_choice_guide<> const& rc) {
+        return rc.size() * sizeof(double) + (rc.buckets() + 1) * sizeof(unsigned int); },
+      results);
+  if (n <= 4096)
+    bench<Engine>(opt, named(proto, "random_choice_lsearch"), weights,
+      [](std::vector<double> const& w) { return walker::detail::random_choice_lsearch<>(w); },
+      real_draw,
+      [n](walker::detail::random_choice_lsearch<> const&) { return n * sizeof(double); },
+      results);
+  bench<Engine>(opt, named(proto, "tower_sampling"), weights,
+    [](std::vector<double> const& w) { return walker::tower_sampling<unsigned int>(w.begin(), w.end()); },
+    direct_draw,
+    [n](walker::tower_sampling<unsigned int> const&) {
+      return (n + 1) * (sizeof(double) + sizeof(unsigned int)); },
+    results);
+  auto tree_bytes = [](std::size_t size) {
+    std::size_t leaves = 1;
+    while (leaves < size) leaves <<= 1;
+    return 2 * leaves * sizeof(double);
+  };
+  bench<Engine>(opt, named(proto, "sum_tree_sampling"), weights,
+    [](std::vector<double> const& w) { return walker::sum_tree_sampling<unsigned int>(w.begin(), w.end()); },
+    direct_draw,
+    [&](walker::sum_tree_sampling<unsigned int> const& rc) { return tree_bytes(rc.size()); },
+    results);
+
+  // tables allocated by aligned_allocator (cache line) and
+  // huge_page_allocator (2 MB transparent huge pages; the kernel may
+  // ignore the request, see /sys/kernel/mm/transparent_hugepage/enabled)
+  typedef walker::aligned_allocator<char> aligned;
+  typedef walker::huge_page_allocator<char> huge;
+  typedef walker::random_choice<Engine, aligned> rc_aligned;
+  typedef walker::random_choice<Engine, huge> rc_huge;
+  bench<Engine>(opt, named(proto, "random_choice_aligned"), weights,
+    [](std::vector<double> const& w) { return rc_aligned(w); },
+    direct_draw,
+    [](rc_aligned const& rc) { return rc.table_bytes(); },
+    results);
+  bench<Engine>(opt, named(proto, "random_choice_huge_page"), weights,
+    [](std::vector<double> const& w) { return rc_huge(w); },
+    direct_draw,
+    [](rc_huge const& rc) { return rc.table_bytes(); },
+    results);
+  typedef walker::detail::random_choice_bsearch<unsigned int, double, aligned> bsearch_aligned;
+  typedef walker::detail::random_choice_bsearch<unsigned int, double, huge> bsearch_huge;
+  bench<Engine>(opt, named(proto, "random_choice_bsearch_aligned"), weights,
+    [](std::vector<double> const& w) { return bsearch_aligned(w); },
+    real_draw,
+    [n](bsearch_aligned const&) { return n * sizeof(double); },
+    results);
+  bench<Engine>(opt, named(proto, "random_choice_bsearch_huge_page"), weights,
+    [](std::vector<double> const& w) { return bsearch_huge(w); },
+    real_draw,
+    [n](bsearch_huge const&) { return n * sizeof(double); },
+    results);
+  typedef walker::tower_sampling<unsigned int, aligned> tower_aligned;
+  typedef walker::tower_sampling<unsigned int, huge> tower_huge;
+  bench<Engine>(opt, named(proto, "tower_sampling_aligned"), weights,
+    [](std::vector<double> const& w) { return tower_aligned(w.begin(), w.end()); },
+    direct_draw,
+    [n](tower_aligned const&) { return (n + 1) * (sizeof(double) + sizeof(unsigned int)); },
+    results);
+  bench<Engine>(opt, named(proto, "tower_sampling_huge_page"), weights,
+    [](std::vector<double> const& w) { return tower_huge(w.begin(), w.end()); },
+    direct_draw,
+    [n](tower_huge const&) { return (n + 1) * (sizeof(double) + sizeof(unsigned int)); },
+    results);
+
+  // many small tables at random sites, packed in one arena and as a
+  // vector of random_choice
+  typedef walker::random_choice_bank<> bank_type;
+  typedef std::vector<rc_type> rc_vector;
+  for (double bins : opt.bank) {
+    const std::size_t b = std::size_t(bins);
+    const std::size_t tables = n / b;
+    if (b == 0 || tables == 0) continue;
+    std::vector<std::vector<double> > list(tables);
+    bool positive = true;
+    for (std::size_t k = 0; k < tables; ++k) {
+      list[k].assign(weights.begin() + std::ptrdiff_t(k * b), weights.begin() + std::ptrdiff_t((k + 1) * b));
+      positive = positive && std::accumulate(list[k].begin(), list[k].end(), 0.0) > 0;
+    }
+    bench<Engine>(opt, named(proto, "random_choice_bank", bins), weights,
+      [&](std::vector<double> const&) {
+        if (!positive) throw std::invalid_argument("a table has no weight");
+        bank_type bank(list, nthreads);
+        bank.check_engine<Engine>();
+        return bank; },
+      [tables](bank_type const& bank, Engine& eng) {
+        return (unsigned int)(bank(std::size_t(eng() % tables), eng)); },
+      [](bank_type const& bank) { return bank.table_bytes(); },
+      results);
+    bench<Engine>(opt, named(proto, "random_choice_vector", bins), weights,
+      [&](std::vector<double> const&) {
+        if (!positive) throw std::invalid_argument("a table has no weight");
+        rc_vector rcs;
+        rcs.reserve(tables);
+        for (auto const& w : list) rcs.emplace_back(w);
+        return rcs; },
+      [tables](rc_vector const& rcs, Engine& eng) {
+        return (unsigned int)(rcs[std::size_t(eng() % tables)](eng)); },
+      [](rc_vector const& rcs) {
+        std::size_t bytes = sizeof(rc_type) * rcs.size();
+        for (auto const& rc : rcs) bytes += rc.table_bytes();
+        return bytes; },
+      results);
+  }
+  if (!serial) return;
+
+  // a random weight updated every `draws' draws: O(log N) update of the
+  // sum tree versus O(N) reconstruction of the alias table
+  typedef updated<walker::sum_tree_sampling<unsigned int> > tree_updated;
+  typedef updated<rc_type> rc_updated;
+  for (double draws : opt.update) {
+    if (draws < 1) continue;
+    bench<Engine>(opt, named(proto, "sum_tree_update", draws), weights,
+      [draws](std::vector<double> const& w) {
+        return tree_updated{ walker::sum_tree_sampling<unsigned int>(w.begin(), w.end()), {}, int(draws), 0 }; },
+      [n](tree_updated& u, Engine& eng) {
+        if (++u.count == u.draws) {
+          u.count = 0;
+          u.rc.update(eng() % n, std::uniform_real_distribution<>()(eng));
+        }
+        return (unsigned int)(u.rc(eng));
+      },
+      [&](tree_updated const& u) { return tree_bytes(u.rc.size()); },
+      results);
+    bench<Engine>(opt, named(proto, "random_choice_update", draws), weights,
+      [draws](std::vector<double> const& w) { return rc_updated{ rc_type(w), w, int(draws), 0 }; },
+      [n](rc_updated& u, Engine& eng) {
+        if (++u.count == u.draws) {
+          u.count = 0;
+          u.weights[eng() % n] = std::uniform_real_distribution<>()(eng);
+          u.rc = rc_type(u.weights);
+        }
+        return (unsigned int)(u.rc(eng));
+      },
+      [](rc_updated const& u) { return u.rc.table_bytes(); },
+      results);
+  }
+
+  // rebuild of the table for the same weights (a sample is a rebuild and
+  // a draw): construction of a new object, and rebuild() in place with
+  // the thread-local or a caller-owned work array
+  typedef rebuilt<rc_type> rc_rebuilt;
+  auto rebuilt_build = [](std::vector<double> const& w) { return rc_rebuilt{ rc_type(w), w, {} }; };
+  auto rebuilt_bytes = [](rc_rebuilt const& r) { return r.rc.table_bytes(); };
+  bench<Engine>(opt, named(proto, "random_choice_construct"), weights, rebuilt_build,
+    [](rc_rebuilt& r, Engine& eng) {
+      r.rc = rc_type(r.weights);
+      return (unsigned int)(r.rc(eng));
+    }, rebuilt_bytes, results);
+  bench<Engine>(opt, named(proto, "random_choice_rebuild"), weights, rebuilt_build,
+    [](rc_rebuilt& r, Engine& eng) {
+      r.rc.rebuild(r.weights);
+      return (unsigned int)(r.rc(eng));
+    }, rebuilt_bytes, results);
+  bench<Engine>(opt, named(proto, "random_choice_rebuild_workspace"), weights, rebuilt_build,
+    [](rc_rebuilt& r, Engine& eng) {
+      r.rc.rebuild(r.weights, r.work);
+      return (unsigned int)(r.rc(eng));
+    }, rebuilt_bytes, results);
+
+  // masked sampling with a fraction of the bins (in random order) masked:
+  // rejection only (threshold 1), tree only (threshold 0) and automatic
+  // switching (default threshold), updates of the mask, and rebuilding
+  // the alias table from the weights of the allowed bins instead
+  typedef std::unique_ptr<masked<rc_type> > masked_ptr;
+  std::vector<unsigned int> order(n);
+  for (std::size_t i = 0; i < n; ++i) order[i] = unsigned(i);
+  std::shuffle(order.begin(), order.end(), gen);
+  auto masked_draw = [](masked_ptr const& p, Engine& eng) { return (unsigned int)(p->ms(eng)); };
+  auto masked_bytes = [](masked_ptr const& p) { return p->rc.table_bytes(); };
+  for (double fraction : opt.masked) {
+    std::size_t m = std::size_t(fraction * n);
+    for (auto const& c : { std::make_pair("masked_rejection", 1.0), std::make_pair("masked_tree", 0.0),
+                           std::make_pair("masked_sampling", 0.8) }) {
+      double threshold = c.second;
+      bench<Engine>(opt, named(proto, c.first, fraction), weights,
+        [&, threshold, m](std::vector<double> const& w) {
+          return masked_ptr(new masked<rc_type>(w, threshold, order, m)); },
+        masked_draw, masked_bytes, results);
+    }
+    bench<Engine>(opt, named(proto, "masked_update", fraction), weights,
+      [&, m](std::vector<double> const& w) { return masked_ptr(new masked<rc_type>(w, 0.8, order, m)); },
+      [n](masked_ptr const& p, Engine& eng) {
+        unsigned int i = p->order[p->count + eng() % (n - p->count)];
+        p->ms.forbid(i);
+        p->ms.allow(i);
+        return i;
+      }, masked_bytes, results);
+    std::vector<double> allowed(weights);
+    for (std::size_t k = 0; k < m; ++k) allowed[order[k]] = 0;
+    bench<Engine>(opt, named(proto, "masked_rebuild", fraction), allowed,
+      rebuilt_build,
+      [](rc_rebuilt& r, Engine& eng) {
+        r.rc = rc_type(r.weights);
+        return (unsigned int)(r.rc(eng));
+      }, rebuilt_bytes, results);
+  }
+
+  // subsets of k distinct elements: rejection of duplicates from the
+  // alias table, sum tree with removal, exponential keys, and automatic
+  // choice
+  typedef buffered<rc_type, char> rc_subset;
+  typedef buffered<walker::subset_sampling<unsigned int>, unsigned int> ss_subset;
+  std::size_t positives = 0;
+  for (auto w : weights) positives += (w > 0);
+  for (double ratio : opt.subset) {
+    std::size_t k = std::min(positives, std::max<std::size_t>(1, std::size_t(ratio * n)));
+    bench<Engine>(opt, named(proto, "subset_rejection", ratio), weights,
+      [](std::vector<double> const& w) { return rc_subset{ rc_type(w), std::vector<char>(w.size(), 0), {} }; },
+      [k](rc_subset& s, Engine& eng) {
+        s.subset.clear();
+        while (s.subset.size() < k) {
+          auto i = s.rc(eng);
+          if (!s.buffer[i]) {
+            s.buffer[i] = 1;
+            s.subset.push_back(i);
+          }
+        }
+        for (auto i : s.subset) s.buffer[i] = 0;
+        return s.subset.back();
+      },
+      [](rc_subset const& s) { return s.rc.table_bytes(); },
+      results);
+    auto ss_build = [](std::vector<double> const& w) {
+      return ss_subset{ walker::subset_sampling<unsigned int>(w.begin(), w.end()), {}, {} };
+    };
+    bench<Engine>(opt, named(proto, "subset_tree", ratio), weights, ss_build,
+      [k](ss_subset& s, Engine& eng) {
+        s.buffer.clear();
+        s.rc.sample_tree(eng, k, std::back_inserter(s.buffer));
+        return s.buffer.back();
+      }, no_table<ss_subset>, results);
+    bench<Engine>(opt, named(proto, "subset_keys", ratio), weights, ss_build,
+      [k](ss_subset& s, Engine& eng) {
+        s.buffer.clear();
+        s.rc.sample_keys(eng, k, std::back_inserter(s.buffer));
+        return s.buffer.back();
+      }, no_table<ss_subset>, results);
+    bench<Engine>(opt, named(proto, "subset_sampling", ratio), weights, ss_build,
+      [k](ss_subset& s, Engine& eng) {
+        s.buffer.clear();
+        s.rc(eng, k, std::back_inserter(s.buffer));
+        return s.buffer.back();
+      }, no_table<ss_subset>, results);
+  }
+
+  // histograms of m draws: loop over the alias table, alias draws,
+  // binomial splitting, and automatic choice
+  typedef buffered<rc_type, std::uint64_t> rc_counts;
+  typedef buffered<walker::multinomial_sampling<>, std::uint64_t> ms_counts;
+  for (double ratio : opt.multinomial) {
+    std::uint64_t m = std::max<std::uint64_t>(1, std::uint64_t(ratio * n));
+    bench<Engine>(opt, named(proto, "multinomial_loop", ratio), weights,
+      [](std::vector<double> const& w) { return rc_counts{ rc_type(w), {}, {} }; },
+      [m, n](rc_counts& c, Engine& eng) {
+        c.buffer.assign(n, 0);
+        for (std::uint64_t t = 0; t < m; ++t) ++c.buffer[c.rc(eng)];
+        return (unsigned int)(c.buffer[0]);
+      },
+      [](rc_counts const& c) { return c.rc.table_bytes(); },
+      results);
+    auto ms_build = [](std::vector<double> const& w) {
+      return ms_counts{ walker::multinomial_sampling<>(w.begin(), w.end()), {}, {} };
+    };
+    bench<Engine>(opt, named(proto, "multinomial_alias", ratio), weights, ms_build,
+      [m](ms_counts& c, Engine& eng) {
+        c.rc.counts_alias(eng, m, c.buffer);
+        return (unsigned int)(c.buffer[0]);
+      }, no_table<ms_counts>, results);
+    bench<Engine>(opt, named(proto, "multinomial_split", ratio), weights, ms_build,
+      [m](ms_counts& c, Engine& eng) {
+        c.rc.counts_split(eng, m, c.buffer);
+        return (unsigned int)(c.buffer[0]);
+      }, no_table<ms_counts>, results);
+    bench<Engine>(opt, named(proto, "multinomial_sampling", ratio), weights, ms_build,
+      [m](ms_counts& c, Engine& eng) {
+        c.rc(eng, m, c.buffer);
+        return (unsigned int)(c.buffer[0]);
+      }, no_table<ms_counts>, results);
+  }
+}
+
+void run(options const& opt, std::string const& ename, std::string const& wname, std::size_t n,
+         unsigned int nthreads, std::vector<result>& results) {
+  if (ename == "mt19937") {
+    run<std::mt19937>(opt, ename, wname, n, nthreads, results);
+  } else if (ename == "mt19937_64") {
+    run<std::mt19937_64>(opt, ename, wname, n, nthreads, results);
+  } else if (ename == "philox4x32") {
+    run<walker::philox4x32>(opt, ename, wname, n, nthreads, results);
+  } else if (ename == "xoshiro256pp_simd") {
+    run<walker::xoshiro256pp_simd>(opt, ename, wname, n, nthreads, results);
+  } else {
+    std::cerr << "Error: unknown engine " << ename << std::endl;
+    std::exit(127);
+  }
+}
+
+// parameter as a CSV field or a JSON value
+std::string param_string(double param, bool json) {
+  if (std::isnan(param)) return json ? "null" : "";
+  std::ostringstream os;
+  os << param;
+  return os.str();
+}
+
+void print_csv(std::vector<result> const& results) {
+  std::cout << "sampler,engine,weights,n,threads,param,build_sec,samples_per_sec,stddev,"
+            << "ns_per_sample,table_bytes,huge_page_kb,cycles_per_sample,llc_misses_per_sample,"
+            << "dtlb_misses_per_sample,xor\n";
+  for (auto const& r : results)
+    std::cout << r.sampler << ',' << r.engine << ',' << r.weights << ',' << r.n << ','
+              << r.threads << ',' << param_string(r.param, false) << ',' << r.build_sec << ','
+              << r.samples_per_sec << ',' << r.stddev << ',' << r.ns_per_sample << ','
+              << r.table_bytes << ',' << r.huge_page_kb << ',' << r.cycles << ',' << r.llc_misses << ','
+              << r.dtlb_misses << ',' << r.xor_sum << '\n';
+}
+
+void print_json(std::vector<result> const& results) {
+  std::cout << "[\n";
+  for (std::size_t i = 0; i < results.size(); ++i) {
+    auto const& r = results[i];
+    std::cout << "  {\"sampler\": \"" << r.sampler << "\", \"engine\": \"" << r.engine
+              << "\", \"weights\": \"" << r.weights << "\", \"n\": " << r.n
+              << ", \"threads\": " << r.threads << ", \"param\": " << param_string(r.param, true)
+              << ", \"build_sec\": " << r.build_sec
+              << ", \"samples_per_sec\": " << r.samples_per_sec << ", \"stddev\": " << r.stddev
+              << ", \"ns_per_sample\": " << r.ns_per_sample << ", \"table_bytes\": " << r.table_bytes
+              << ", \"huge_page_kb\": " << r.huge_page_kb
+              << ", \"cycles_per_sample\": " << r.cycles << ", \"llc_misses_per_sample\": "
+              << r.llc_misses << ", \"dtlb_misses_per_sample\": " << r.dtlb_misses
+              << ", \"xor\": " << r.xor_sum << "}"
+              << (i + 1 < results.size() ? ",\n" : "\n");
+  }
+  std::cout << "]\n";
+}
+
+std::vector<std::string> split(std::string const& s) {
+  std::vector<std::string> list;
+  std::size_t first = 0;
+  while (true) {
+    std::size_t last = s.find(',', first);
+    list.push_back(s.substr(first, last - first));
+    if (last == std::string::npos) break;
+    first = last + 1;
+  }
+  return list;
+}
+
+std::vector<double> split_values(std::string const& s) {
+  std::vector<double> list;
+  for (auto const& v : split(s)) list.push_back(std::atof(v.c_str()));
+  return list;
+}
+
+int main(int argc, char** argv) {
+  options opt;
+  std::vector<std::string> args(argv + 1, argv + argc);
+  std::vector<std::string> positional;
+  for (std::size_t i = 0; i < args.size(); ++i) {
+    if (args[i] == "--json") {
+      opt.json = true;
+    } else if (args[i] == "--csv") {
+      opt.json = false;
+    } else if (args[i] == "--counters") {
+      opt.counters = true;
+    } else if (args[i] == "--repeat" && i + 1 < args.size()) {
+      opt.repeat = std::max(1, std::atoi(args[++i].c_str()));
+    } else if (args[i] == "--samplers" && i + 1 < args.size()) {
+      opt.samplers = split(args[++i]);
+    } else if (args[i] == "--engines" && i + 1 < args.size()) {
+      opt.engines = split(args[++i]);
+    } else if (args[i] == "--weights" && i + 1 < args.size()) {
+      opt.weights = split(args[++i]);
+    } else if (args[i] == "--threads" && i + 1 < args.size()) {
+      opt.threads.clear();
+      for (auto t : split_values(args[++i]))
+        opt.threads.push_back(t > 0 ? unsigned(t) : walker::detail::default_concurrency());
+    } else if (args[i] == "--subset" && i + 1 < args.size()) {
+      opt.subset = split_values(args[++i]);
+    } else if (args[i] == "--multinomial" && i + 1 < args.size()) {
+      opt.multinomial = split_values(args[++i]);
+    } else if (args[i] == "--update" && i + 1 < args.size()) {
+      opt.update = split_values(args[++i]);
+    } else if (args[i] == "--masked" && i + 1 < args.size()) {
+      opt.masked = split_values(args[++i]);
+    } else if (args[i] == "--bank" && i + 1 < args.size()) {
+      opt.bank = split_values(args[++i]);
+    } else {
+      positional.push_back(args[i]);
+    }
+  }
+  if (positional.size() >= 2) {
+    opt.duration = std::atof(positional[0].c_str());
+    for (std::size_t i = 1; i < positional.size(); ++i)
+      opt.sizes.push_back(std::size_t(std::atof(positional[i].c_str())));
+  } else {
+    std::cerr << "Error: " << argv[0] << " [--csv|--json] [--repeat r] [--counters] "
+              << "[--samplers name,...] [--engines name,...] [--weights name,...] "
+              << "[--threads t,...] [--subset k/n,...] [--multinomial m/n,...] "
+              << "[--update draws,...] [--masked fraction,...] [--bank bins,...] duration size0...\n";
+    std::exit(127);
+  }
+  if (opt.counters && !perf_event().available())
+    std::cerr << "Warning: hardware counters are not available\n";
+
+  std::vector<result> results;
+  for (auto const& e : opt.engines)
+    for (auto const& w : opt.weights)
+      for (auto n : opt.sizes)
+        for (auto t : opt.threads) run(opt, e, w, n, t, results);
+  if (opt.json)
+    print_json(results);
+  else
+    print_csv(results);
+}
@@ -0,0 +1,143 @@
+/*
+   Copyright (C) 2022 by Synge Todo <wistaria@phys.s.u-tokyo.ac.jp>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+// Samplers with tables allocated by aligned_allocator and
+// huge_page_allocator must give exactly the same samples as those with
+// the default allocator.  The tables must be aligned to a cache line,
+// and those of at least 2 MB to a huge page.
+
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "walker/allocator.hpp"
+#include "walker/random_choice.hpp"
+#include "walker/tower_sampling.hpp"
+
+static const unsigned int samples = 100000;
+
+// uniform real number generator in [0,1)
+template<class Engine>
+struct uniform_01 {
+  uniform_01(Engine const& eng) : eng_(eng) {}
+  double operator()() { return dist_(eng_); }
+  Engine eng_;
+  std::uniform_real_distribution<> dist_;
+};
+
+template<class RC0, class RC1, class Engine>
+bool compare(std::string const& name, RC0 const& rc0, RC1 const& rc1, Engine const& eng) {
+  Engine e0 = eng, e1 = eng;
+  bool same = true;
+  for (unsigned int t = 0; t < samples; ++t) same &= (rc0(e0) == rc1(e1));
+  std::cout << name << ": " << (same ? "succeeded" : "failed") << std::endl;
+  return same;
+}
+
+bool aligned(std::string const& name, const void* p, std::size_t alignment) {
+  bool r = (reinterpret_cast<std::uintptr_t>(p) % alignment) == 0;
+  std::cout << name << " aligned to " << alignment << " bytes: " << (r ? "succeeded" : "failed")
+            << std::endl;
+  return r;
+}
+
+int main() {
+try {
+  typedef std::mt19937 engine_type;
+  engine_type eng(29411);
+  std::uniform_real_distribution<> dist;
+  bool r = true;
+
+  // raw allocations, small and large
+  {
+    walker::aligned_allocator<double> a64;
+    walker::aligned_allocator<char, 4096> a4k;
+    walker::huge_page_allocator<double> huge;
+    for (std::size_t n : { 1, 3, 1000, 300000, 1000000 }) {
+      std::string size = std::to_string(n * sizeof(double)) + " bytes";
+      double* p = a64.allocate(n);
+      r &= aligned("aligned_allocator, " + size, p, 64);
+      a64.deallocate(p, n);
+      char* c = a4k.allocate(n);
+      r &= aligned("aligned_allocator<char, 4096>, " + size, c, 4096);
+      a4k.deallocate(c, n);
+      double* q = huge.allocate(n);
+      r &= aligned("huge_page_allocator, " + size, q,
+                   n * sizeof(double) >= walker::detail::huge_page_size ?
+                   walker::detail::huge_page_size : 64);
+      for (std::size_t i = 0; i < n; ++i) q[i] = double(i);
+      for (std::size_t i = 0; i < n; ++i) r &= (q[i] == double(i));
+      huge.deallocate(q, n);
+    }
+    r &= (a64 == walker::aligned_allocator<int>()) && (huge == walker::huge_page_allocator<char>());
+  }
+
+  for (std::size_t n : { 1000, 1000000 }) {
+    std::cout << "number of bins = " << n << std::endl;
+    std::vector<double> weights(n);
+    for (auto& w : weights) w = dist(eng);
+
+    // integer-based Walker algorithm
+    walker::random_choice<engine_type> rc(weights);
+    walker::random_choice<engine_type, walker::aligned_allocator<char> > rc_aligned(weights);
+    walker::random_choice<engine_type, walker::huge_page_allocator<char> > rc_huge(weights);
+    walker::random_choice<engine_type, walker::huge_page_allocator<char> > rc_parallel(weights, 2);
+    r &= rc_huge.check(weights) && rc_parallel.check(weights);
+    r &= compare("random_choice, aligned_allocator", rc, rc_aligned, eng);
+    r &= compare("random_choice, huge_page_allocator", rc, rc_huge, eng);
+    rc_huge.rebuild(weights);
+    r &= compare("random_choice, huge_page_allocator, rebuilt", rc, rc_huge, eng);
+
+    // double-based Walker algorithm and binary search
+    uniform_01<engine_type> u01(eng);
+    walker::random_choice<double> rd(weights);
+    walker::random_choice<double, walker::huge_page_allocator<char> > rd_huge(weights);
+    r &= compare("random_choice<double>, huge_page_allocator", rd, rd_huge, u01);
+    walker::detail::random_choice_bsearch<> bs(weights);
+    walker::detail::random_choice_bsearch<unsigned int, double,
+      walker::huge_page_allocator<double> > bs_huge(weights);
+    r &= compare("random_choice_bsearch, huge_page_allocator", bs, bs_huge, u01);
+
+    // tower sampling
+    walker::tower_sampling<> ts(weights.begin(), weights.end());
+    walker::tower_sampling<int, walker::aligned_allocator<double> >
+      ts_aligned(weights.begin(), weights.end());
+    walker::tower_sampling<int, walker::huge_page_allocator<double> >
+      ts_huge(weights.begin(), weights.end());
+    r &= compare("tower_sampling, aligned_allocator", ts, ts_aligned, eng);
+    r &= compare("tower_sampling, huge_page_allocator", ts, ts_huge, eng);
+
+    // copy and move keep the allocator
+    auto rc_copy = rc_huge;
+    auto rc_moved = std::move(rc_copy);
+    r &= compare("random_choice, huge_page_allocator, copied", rc, rc_moved, eng);
+  }
+
+  if (r) {
+    std::cout << "check succeeded\n";
+  } else {
+    std::cout << "check failed\n";
+    std::exit(-1);
+  }
+}
+catch (const std::exception& excp) {
+  std::cerr << excp.what() << std::endl;
+  std::exit(-1); }
+catch (...) {
+  std::cerr << "Unknown exception occurred!" << std::endl;
+  std::exit(-1); }
+}
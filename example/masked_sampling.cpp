@@ -0,0 +1,113 @@
+/*
+   Copyright (C) 2022 by Synge Todo <wistaria@phys.s.u-tokyo.ac.jp>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "walker/masked_sampling.hpp"
+#include "walker/random_choice.hpp"
+
+static const unsigned int n = 9;
+static const unsigned int samples = 100000;
+
+typedef std::mt19937 engine_type;
+typedef walker::random_choice<engine_type> alias_type;
+
+// the samples follow the weights of the allowed bins
+void test(std::string const& name, walker::masked_sampling<alias_type> const& ms,
+          std::vector<double> const& weights, engine_type& eng) {
+  std::cout << name << " (masked mass = " << ms.masked_mass() << ", "
+            << (ms.uses_tree() ? "tree" : "rejection") << ")\n";
+  double tw = 0;
+  for (unsigned int i = 0; i < n; ++i)
+    if (!ms.forbidden(i)) tw += weights[i];
+  std::vector<double> accum(n, 0);
+  for (unsigned int t = 0; t < samples; ++t) ++accum[ms(eng)];
+  std::cout << "bin\tweight\t\tresult\t\tdiff\t\tsigma\t\tdiff/sigma\n";
+  for (unsigned int i = 0; i < n; ++i) {
+    double p = ms.forbidden(i) ? 0 : weights[i] / tw;
+    double diff = std::abs(p - (accum[i] / samples));
+    double sigma = std::sqrt(accum[i]) / samples;
+    std::cout << i << "\t" << p << "    \t"
+              << (accum[i] / samples) << "    \t" << diff << "    \t"
+              << sigma << "    \t" << (diff / sigma) << std::endl;
+    if ((ms.forbidden(i) && accum[i] > 0) || diff > 5 * sigma + 1e-12) {
+      std::cout << "check failed\n";
+      std::exit(-1);
+    }
+  }
+}
+
+int main() {
+try {
+  std::cout << "number of bins = " << n << std::endl;
+  std::cout << "number of samples = " << samples << std::endl;
+
+  engine_type eng(29411);
+  std::uniform_real_distribution<> dist;
+  std::vector<double> weights(n);
+  for (auto& w : weights) w = dist(eng);
+  weights[4] = 0;
+
+  alias_type rc(weights);
+  walker::masked_sampling<alias_type> ms(rc, weights, 0.5);
+  test("no mask", ms, weights, eng);
+
+  // rejection while the masked mass is small, tree of partial sums beyond the threshold
+  ms.forbid(2);
+  test("bin 2 masked", ms, weights, eng);
+  std::vector<unsigned int> many = { 0, 1, 3, 5, 6 };
+  ms.forbid(many.begin(), many.end());
+  test("bins 0-3, 5, 6 masked", ms, weights, eng);
+  if (!ms.uses_tree()) {
+    std::cout << "tree expected\n";
+    std::exit(-1);
+  }
+  ms.allow(0);
+  ms.allow(5);
+  test("bins 1-3, 6 masked", ms, weights, eng);
+  ms.allow(many.begin(), many.end());
+  test("bin 2 masked again", ms, weights, eng);
+  if (ms.uses_tree()) {
+    std::cout << "rejection expected\n";
+    std::exit(-1);
+  }
+
+  // always the tree
+  walker::masked_sampling<alias_type> mt(rc, weights, 0);
+  mt.forbid(7);
+  test("bin 7 masked, tree only", mt, weights, eng);
+
+  // all the bins of positive weight masked
+  ms.clear();
+  for (unsigned int i = 0; i < n; ++i) if (i != 4) ms.forbid(i);
+  bool thrown = false;
+  try { ms(eng); } catch (std::range_error const&) { thrown = true; }
+  if (!thrown) {
+    std::cout << "exception expected\n";
+    std::exit(-1);
+  }
+  std::cout << "check succeeded\n";
+}
+catch (const std::exception& excp) {
+  std::cerr << excp.what() << std::endl;
+  std::exit(-1); }
+catch (...) {
+  std::cerr << "Unknown exception occurred!" << std::endl;
+  std::exit(-1); }
+}
@@ -0,0 +1,94 @@
+/*
+   Copyright (C) 2022 by Synge Todo <wistaria@phys.s.u-tokyo.ac.jp>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "walker/multinomial_sampling.hpp"
+
+static const unsigned int n = 9;
+
+template<class COUNTS>
+void test(std::string const& name, std::vector<double> const& weights, std::uint64_t m,
+          COUNTS const& counts_of) {
+  double tw = 0;
+  for (unsigned int i = 0; i < n; ++i) tw += weights[i];
+  std::vector<std::uint64_t> counts;
+  counts_of(m, counts);
+  std::cout << name << ": number of draws = " << m << std::endl;
+
+  std::uint64_t total = 0;
+  for (auto c : counts) total += c;
+  if (counts.size() != n || total != m) {
+    std::cout << "total count mismatch\n";
+    std::exit(-1);
+  }
+
+  // each count follows Binomial(m, p_i)
+  std::cout << "bin\tweight\t\tresult\t\tdiff\t\tsigma\t\tdiff/sigma\n";
+  for (unsigned int i = 0; i < n; ++i) {
+    double p = weights[i] / tw;
+    double diff = std::abs(p - double(counts[i]) / m);
+    double sigma = std::sqrt(p * (1 - p) / m);
+    std::cout << i << "\t" << p << "    \t"
+              << (double(counts[i]) / m) << "    \t" << diff << "    \t"
+              << sigma << "    \t" << (diff / sigma) << std::endl;
+    if ((p == 0 && counts[i] != 0) || diff > 5 * sigma) {
+      std::cout << "check failed\n";
+      std::exit(-1);
+    }
+  }
+}
+
+int main() {
+try {
+  std::cout << "number of bins = " << n << std::endl;
+
+  std::vector<double> weights(n);
+
+  // random number generator
+  typedef std::mt19937 engine_type;
+  engine_type eng(29411);
+  std::uniform_real_distribution<> dist;
+
+  // generate weights
+  for (auto& w : weights) w = dist(eng);
+  weights[2] = 0;
+  weights[n - 1] = 0;
+
+  walker::multinomial_sampling<> ms(weights.begin(), weights.end());
+  for (std::uint64_t m : { std::uint64_t(1000), std::uint64_t(100000000),
+                           std::uint64_t(1) << 40 }) {
+    if (m < (1 << 30))
+      test("alias", weights, m, [&](std::uint64_t m, std::vector<std::uint64_t>& c) {
+        ms.counts_alias(eng, m, c); });
+    test("split", weights, m, [&](std::uint64_t m, std::vector<std::uint64_t>& c) {
+      ms.counts_split(eng, m, c); });
+    test("auto", weights, m, [&](std::uint64_t m, std::vector<std::uint64_t>& c) {
+      ms(eng, m, c); });
+  }
+  std::cout << "check succeeded\n";
+}
+catch (const std::exception& excp) {
+  std::cerr << excp.what() << std::endl;
+  std::exit(-1); }
+catch (...) {
+  std::cerr << "Unknown exception occurred!" << std::endl;
+  std::exit(-1); }
+}
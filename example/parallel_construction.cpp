@@ -0,0 +1,76 @@
+/*
+   Copyright (C) 2022 by Synge Todo <wistaria@phys.s.u-tokyo.ac.jp>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "walker/random_choice.hpp"
+
+static const unsigned int n = 5000;
+
+template<class CutoffType>
+bool check(std::string const& name, std::vector<double> const& weights) {
+  bool r = true;
+  for (unsigned int nthreads : { 1, 2, 3, 7 }) {
+    std::vector<std::pair<CutoffType, unsigned int> > table;
+    walker::detail::fill_hs2019(weights, table, nthreads);
+    bool c = walker::detail::check_table(weights, table);
+    std::cout << name << " (" << nthreads << " threads): check "
+              << (c ? "succeeded" : "failed") << std::endl;
+    r &= c;
+  }
+  return r;
+}
+
+int main() {
+try {
+  std::cout << "number of bins = " << n << std::endl;
+
+  // random number generator
+  typedef std::mt19937 engine_type;
+  engine_type eng(29411);
+  std::uniform_real_distribution<> dist;
+
+  std::vector<std::pair<std::string, std::vector<double> > > cases;
+  std::vector<double> weights(n);
+  for (auto& w : weights) w = dist(eng);
+  cases.emplace_back("uniform", weights);
+  for (auto& w : weights) w = std::exp(-20 * dist(eng));
+  cases.emplace_back("exponential", weights);
+  for (auto& w : weights) w = (dist(eng) < 0.9) ? 0 : dist(eng);
+  cases.emplace_back("many-zeros", weights);
+  for (auto& w : weights) w = 1;
+  cases.emplace_back("constant", weights);
+  for (auto& w : weights) w = 0;
+  weights[n / 3] = 1;
+  cases.emplace_back("one-hot", weights);
+
+  bool r = true;
+  for (auto const& c : cases) {
+    r &= check<double>(c.first + ", double-base", c.second);
+    r &= check<unsigned int>(c.first + ", integer-base", c.second);
+  }
+  if (!r) std::exit(-1);
+}
+catch (const std::exception& excp) {
+  std::cerr << excp.what() << std::endl;
+  std::exit(-1); }
+catch (...) {
+  std::cerr << "Unknown exception occurred!" << std::endl;
+  std::exit(-1); }
+}
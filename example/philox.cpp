@@ -0,0 +1,158 @@
+/*
+   Copyright (C) 2022 by Synge Todo <wistaria@phys.s.u-tokyo.ac.jp>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "walker/philox.hpp"
+#include "walker/random_choice.hpp"
+
+static const unsigned int n = 1000;
+static const unsigned int samples = 100003;
+static const unsigned int nthreads = 4;
+
+void report(std::string const& name, bool r) {
+  std::cout << name << ": check " << (r ? "succeeded" : "failed") << std::endl;
+  if (!r) std::exit(-1);
+}
+
+int main() {
+try {
+  std::cout << "number of bins = " << n << std::endl;
+  std::cout << "number of samples = " << samples << std::endl;
+
+  // known answers of Philox4x32-10 (Random123 kat_vectors)
+  {
+    std::uint32_t c0[4] = { 0, 0, 0, 0 };
+    walker::detail::philox4x32_10(c0, 0, 0);
+    std::uint32_t c1[4] = { 0xffffffffu, 0xffffffffu, 0xffffffffu, 0xffffffffu };
+    walker::detail::philox4x32_10(c1, 0xffffffffu, 0xffffffffu);
+    std::uint32_t c2[4] = { 0x243f6a88u, 0x85a308d3u, 0x13198a2eu, 0x03707344u };
+    walker::detail::philox4x32_10(c2, 0xa4093822u, 0x299f31d0u);
+    report("known answers",
+      c0[0] == 0x6627e8d5u && c0[1] == 0xe169c58du && c0[2] == 0xbc57ac4cu && c0[3] == 0x9b00dbd8u &&
+      c1[0] == 0x408f276du && c1[1] == 0x41c83b0eu && c1[2] == 0xa20bc7c6u && c1[3] == 0x6d5451fdu &&
+      c2[0] == 0xd16cfe09u && c2[1] == 0x94fdccebu && c2[2] == 0x5001e420u && c2[3] == 0x24126ea1u);
+  }
+
+  // discard(z) is equivalent to z calls
+  {
+    bool r = true;
+    for (unsigned long long z : { 0, 1, 3, 4, 5, 1000, 1001 }) {
+      walker::philox4x32 eng0, eng1;
+      eng0(); eng1();
+      for (unsigned long long i = 0; i < z; ++i) eng0();
+      eng1.discard(z);
+      r &= (eng0 == eng1) && (eng0() == eng1()) && (eng0() == eng1());
+    }
+    report("discard", r);
+  }
+
+  // fill() returns the same words as operator() for any alignment
+  const walker::detail::simd_isa best = walker::detail::simd_level();
+  for (auto isa : { walker::detail::simd_isa::scalar, walker::detail::simd_isa::avx2,
+                    walker::detail::simd_isa::avx512 }) {
+    if (isa > best) continue;
+    walker::detail::simd_level() = isa;
+    bool r = true;
+    for (unsigned int offset : { 0, 1, 2, 3 }) {
+      // the block index crosses 2^32 in the middle
+      walker::philox4x32 eng0(7, 3), eng1(7, 3);
+      eng0.seek((std::uint64_t(1) << 34) - 4 * 13 + offset);
+      eng1.seek((std::uint64_t(1) << 34) - 4 * 13 + offset);
+      std::vector<std::uint32_t> ref(157), words(157);
+      for (auto& w : ref) w = eng0();
+      eng1.fill(words.data(), words.data() + words.size());
+      r &= (ref == words) && (eng0 == eng1);
+    }
+    report("fill (instruction set = " + std::to_string(int(isa)) + ")", r);
+  }
+  walker::detail::simd_level() = best;
+
+  // generate weights
+  std::mt19937 gen(29411);
+  std::uniform_real_distribution<> dist;
+  std::vector<double> weights(n);
+  for (auto& w : weights) w = dist(gen);
+  walker::random_choice<walker::philox4x32> rc(weights);
+  if (!rc.check(weights)) report("table", false);
+
+  // serial reference: the samples of one engine, and those of `nthreads' streams
+  std::vector<unsigned int> ref(samples), ref_streams(nthreads * samples);
+  walker::philox4x32 eng;
+  for (auto& x : ref) x = rc(eng);
+  for (unsigned int k = 0; k < nthreads; ++k) {
+    walker::philox4x32 e = eng.split(k + 1);
+    for (unsigned int i = 0; i < samples; ++i) ref_streams[k * samples + i] = rc(e);
+  }
+
+  // each thread skips ahead to its chunk of one sequence (two words per sample)
+  {
+    std::vector<unsigned int> result(samples);
+    std::vector<std::thread> workers;
+    for (unsigned int k = 0; k < nthreads; ++k)
+      workers.emplace_back([&, k]() {
+        std::size_t first = std::size_t(samples) * k / nthreads;
+        std::size_t last = std::size_t(samples) * (k + 1) / nthreads;
+        walker::philox4x32 e;
+        e.discard(2 * first);
+        if (k % 2)
+          rc.generate(e, result.data() + first, result.data() + last);
+        else
+          for (std::size_t i = first; i < last; ++i) result[i] = rc(e);
+      });
+    for (auto& w : workers) w.join();
+    report("skip-ahead in parallel", result == ref);
+  }
+
+  // each thread samples from its own stream
+  {
+    std::vector<unsigned int> result(nthreads * samples);
+    std::vector<std::thread> workers;
+    for (unsigned int k = 0; k < nthreads; ++k)
+      workers.emplace_back([&, k]() {
+        walker::philox4x32 e = eng.split(k + 1);
+        rc.generate(e, result.data() + k * samples, result.data() + (k + 1) * samples);
+      });
+    for (auto& w : workers) w.join();
+    report("streams in parallel", result == ref_streams);
+  }
+
+  // the samples follow the weights
+  {
+    double tw = 0;
+    for (auto w : weights) tw += w;
+    std::vector<double> accum(n, 0);
+    for (auto x : ref_streams) ++accum[x];
+    double chi2 = 0;
+    for (unsigned int i = 0; i < n; ++i) {
+      double e = weights[i] / tw * ref_streams.size();
+      chi2 += (accum[i] - e) * (accum[i] - e) / e;
+    }
+    std::cout << "chi2/dof = " << chi2 / (n - 1) << std::endl;
+    report("distribution", chi2 / (n - 1) < 1.2);
+  }
+}
+catch (const std::exception& excp) {
+  std::cerr << excp.what() << std::endl;
+  std::exit(-1); }
+catch (...) {
+  std::cerr << "Unknown exception occurred!" << std::endl;
+  std::exit(-1); }
+}
@@ -90,6 +90,52 @@ try {
                 << sigma << "    \t" << (diff / sigma) << std::endl;
     }
   }
+
+  // packed-table version
+  {
+    // random_choice
+    walker::detail::random_choice_packed<> rc(weights);
+    auto u01 = [&]() { return dist(eng); };
+
+    // check
+    if (rc.check(weights)) {
+      std::cout << "check succeeded\n";
+    } else {
+      std::cout << "check failed\n";
+      std::exit(-1);
+    }
+
+    std::vector<double> accum(n, 0);
+    for (unsigned int t = 0; t < samples; ++t) ++accum[rc(u01)];
+
+    std::cout << "bin\tweight\t\tresult\t\tdiff\t\tsigma\t\tdiff/sigma\n";
+    for (unsigned int i = 0; i < n; ++i) {
+      double diff = std::abs((weights[i] / tw) - (accum[i] / samples));
+      double sigma = std::sqrt(accum[i]) / samples;
+      std::cout << i << "\t" << (weights[i] / tw) << "    \t"
+                << (accum[i] / samples) << "    \t" << diff << "    \t"
+                << sigma << "    \t" << (diff / sigma) << std::endl;
+    }
+  }
+
+  // guide-table version
+  {
+    // random_choice
+    walker::detail::random_choice_guide<> rc(weights);
+    auto u01 = [&]() { return dist(eng); };
+
+    std::vector<double> accum(n, 0);
+    for (unsigned int t = 0; t < samples; ++t) ++accum[rc(u01)];
+
+    std::cout << "bin\tweight\t\tresult\t\tdiff\t\tsigma\t\tdiff/sigma\n";
+    for (unsigned int i = 0; i < n; ++i) {
+      double diff = std::abs((weights[i] / tw) - (accum[i] / samples));
+      double sigma = std::sqrt(accum[i]) / samples;
+      std::cout << i << "\t" << (weights[i] / tw) << "    \t"
+                << (accum[i] / samples) << "    \t" << diff << "    \t"
+                << sigma << "    \t" << (diff / sigma) << std::endl;
+    }
+  }
 }
 catch (const std::exception& excp) {
   std::cerr << excp.what() << std::endl;
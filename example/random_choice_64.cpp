@@ -0,0 +1,149 @@
+/*
+   Copyright (C) 2022 by Synge Todo <wistaria@phys.s.u-tokyo.ac.jp>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+
+// Chi-square tests of tables with 64-bit cutoff values and indices, and
+// of integer tables sampled with engines of various bit widths
+
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "walker/random_choice.hpp"
+
+static const unsigned int n = 1000;
+static const unsigned int samples = 10000000;
+
+// 40-bit engine, of which the shifts can not be guessed from result_type
+class engine40 {
+public:
+  typedef std::uint64_t result_type;
+  explicit engine40(result_type seed) : eng_(seed) {}
+  static constexpr result_type min() { return 0; }
+  static constexpr result_type max() { return (result_type(1) << 40) - 1; }
+  result_type operator()() { return eng_() >> 24; }
+private:
+  std::mt19937_64 eng_;
+};
+
+// 8-bit engine, too narrow for tables of more than 256 entries
+class engine8 {
+public:
+  typedef std::uint32_t result_type;
+  static constexpr result_type min() { return 0; }
+  static constexpr result_type max() { return 255; }
+  result_type operator()() { return 0; }
+};
+
+template<class F>
+bool chi_square_test(std::string const& name, F const& draw, std::vector<double> const& weights) {
+  double tw = 0;
+  for (auto w : weights) tw += w;
+  std::vector<double> accum(n, 0);
+  for (unsigned int t = 0; t < samples; ++t) {
+    auto x = draw();
+    if (x >= n) {
+      std::cout << name << ": out of range " << x << std::endl;
+      return false;
+    }
+    ++accum[x];
+  }
+  double chi2 = 0;
+  for (unsigned int i = 0; i < n; ++i) {
+    double expected = samples * weights[i] / tw;
+    chi2 += (accum[i] - expected) * (accum[i] - expected) / expected;
+  }
+  // accept up to 5 standard deviations of the chi-square distribution
+  double dof = n - 1;
+  double limit = dof + 5 * std::sqrt(2 * dof);
+  std::cout << name << ": chi2 = " << chi2 << " (dof = " << dof << ", limit = " << limit << ")\n";
+  return chi2 < limit;
+}
+
+int main() {
+try {
+  std::cout << "number of bins = " << n << std::endl;
+  std::cout << "number of samples = " << samples << std::endl;
+
+  std::mt19937 eng32(29411);
+  std::mt19937_64 eng64(29411);
+  engine40 eng40(29411);
+  std::uniform_real_distribution<> dist;
+
+  std::vector<double> weights(n);
+  for (auto& w : weights) w = dist(eng64);
+
+  bool r = true;
+
+  // random_choice for a 64-bit engine has 64-bit cutoff values and indices
+  typedef walker::random_choice<std::mt19937_64> rc64_type;
+  static_assert(std::is_same<rc64_type::result_type, std::uint64_t>::value, "64-bit index expected");
+  static_assert(std::is_same<walker::random_choice<std::mt19937>::result_type, unsigned int>::value,
+    "32-bit index expected");
+  rc64_type rc64(weights);
+  r &= rc64.check(weights);
+  r &= chi_square_test("64-bit table, 64-bit engine", [&]() { return rc64(eng64); }, weights);
+  r &= chi_square_test("64-bit table, single draw", [&]() { return rc64.single_draw(eng64); }, weights);
+  r &= chi_square_test("64-bit table, 32-bit engine", [&]() { return rc64(eng32); }, weights);
+  r &= chi_square_test("64-bit table, 40-bit engine", [&]() { return rc64(eng40); }, weights);
+
+  // 32-bit table with wider engines
+  walker::random_choice<std::mt19937> rc32(weights);
+  r &= chi_square_test("32-bit table, 64-bit engine", [&]() { return rc32(eng64); }, weights);
+  r &= chi_square_test("32-bit table, 40-bit engine", [&]() { return rc32(eng40); }, weights);
+
+  // the engine width is checked once, not per draw
+  rc32.check_engine<engine40>();
+  bool thrown = false;
+  try { rc32.check_engine<engine8>(); } catch (std::range_error&) { thrown = true; }
+  r &= thrown;
+  thrown = false;
+  std::vector<unsigned int> out(16);
+  engine8 eng8;
+  try { rc32.generate(eng8, out.data(), out.data() + out.size()); } catch (std::range_error&) { thrown = true; }
+  r &= thrown;
+
+  // save and load keep the shifts
+  const char* file = "random_choice_64.tbl";
+  rc64.save(file);
+  rc64_type loaded;
+  loaded.load(file);
+  std::remove(file);
+  std::mt19937_64 e1(1234), e2(1234);
+  for (unsigned int t = 0; t < 1000; ++t) r &= (rc64(e1) == loaded(e2));
+
+  // uniform weights: all the cutoff values are clamped to the maximum
+  walker::random_choice_compact<walker::width_u64> uniform(std::vector<double>(n, 1));
+  r &= uniform.check(std::vector<double>(n, 1));
+
+  if (r) {
+    std::cout << "check succeeded\n";
+  } else {
+    std::cout << "check failed\n";
+    std::exit(-1);
+  }
+}
+catch (const std::exception& excp) {
+  std::cerr << excp.what() << std::endl;
+  std::exit(-1); }
+catch (...) {
+  std::cerr << "Unknown exception occurred!" << std::endl;
+  std::exit(-1); }
+}
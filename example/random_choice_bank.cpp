@@ -0,0 +1,167 @@
+/*
+   Copyright (C) 2022 by Synge Todo <wistaria@phys.s.u-tokyo.ac.jp>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+// Chi-square test of random_choice_bank with tables of various sizes
+// (including a single bin and zero weights), comparison with
+// random_choice, parallel construction, and rebuild of a table
+
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "walker/random_choice.hpp"
+#include "walker/random_choice_bank.hpp"
+
+static const unsigned int samples = 1000000;
+
+template<class Bank, class Engine>
+bool chi_square_test(std::string const& name, Bank const& bank, std::size_t k, Engine& eng,
+                     std::vector<double> const& weights) {
+  std::size_t n = weights.size();
+  double tw = 0;
+  for (auto w : weights) tw += w;
+  std::vector<double> accum(n, 0);
+  for (unsigned int t = 0; t < samples; ++t) {
+    auto x = bank(k, eng);
+    if (x >= n) {
+      std::cout << name << ": padding bin " << x << " sampled\n";
+      return false;
+    }
+    ++accum[x];
+  }
+  double chi2 = 0;
+  std::size_t dof = 0;
+  bool zeros = true;
+  for (std::size_t i = 0; i < n; ++i) {
+    if (weights[i] > 0) {
+      double expected = samples * weights[i] / tw;
+      chi2 += (accum[i] - expected) * (accum[i] - expected) / expected;
+      ++dof;
+    } else {
+      zeros &= (accum[i] == 0);
+    }
+  }
+  // accept up to 5 standard deviations of the chi-square distribution
+  if (dof > 1) dof -= 1;
+  double limit = dof + 5 * std::sqrt(2.0 * dof);
+  std::cout << name << ": chi2 = " << chi2 << " (dof = " << dof << ", limit = " << limit
+            << ")" << (zeros ? "" : ", zero-weight bin sampled") << std::endl;
+  return zeros && chi2 < limit;
+}
+
+// 4-bit engine, too narrow for tables of more than 16 entries
+class engine4 {
+public:
+  typedef std::uint32_t result_type;
+  static constexpr result_type min() { return 0; }
+  static constexpr result_type max() { return 15; }
+  result_type operator()() { return 0; }
+};
+
+int main() {
+try {
+  std::mt19937 eng(29411);
+  std::mt19937_64 eng64(29411);
+  std::uniform_real_distribution<> dist;
+
+  // 100 tables of 1 to 100 bins
+  std::vector<std::vector<double> > weights_list(100);
+  for (std::size_t k = 0; k < weights_list.size(); ++k) {
+    weights_list[k].resize(k + 1);
+    for (auto& w : weights_list[k]) w = dist(eng);
+    if (k > 10) weights_list[k][k / 2] = 0;
+  }
+  walker::random_choice_bank<> bank(weights_list);
+  std::cout << "number of tables = " << bank.size() << ", memory = " << bank.table_bytes()
+            << " bytes\n";
+
+  bool r = true;
+
+  // the engine width is checked once against the largest table
+  bank.check_engine<std::mt19937>();
+  bool narrow = false;
+  try { bank.check_engine<engine4>(); } catch (std::range_error const&) { narrow = true; }
+  r &= narrow;
+  for (std::size_t k = 0; k < bank.size(); ++k) {
+    if (!bank.check(k, weights_list[k])) {
+      std::cout << "table check failed for table " << k << std::endl;
+      r = false;
+    }
+  }
+  for (std::size_t k : { 0, 1, 2, 7, 63, 64, 99 }) {
+    r &= chi_square_test("table " + std::to_string(k) + " (32-bit engine)", bank, k, eng,
+                         weights_list[k]);
+    r &= chi_square_test("table " + std::to_string(k) + " (64-bit engine)", bank, k, eng64,
+                         weights_list[k]);
+  }
+
+  // the same random numbers give the same samples as random_choice
+  {
+    bool same = true;
+    for (std::size_t k = 0; k < bank.size(); ++k) {
+      walker::random_choice<std::mt19937> rc(weights_list[k]);
+      std::mt19937 e0(k), e1(k);
+      for (int t = 0; t < 1000; ++t) same &= (rc(e0) == bank(k, e1));
+    }
+    std::cout << "comparison with random_choice: " << (same ? "succeeded" : "failed") << std::endl;
+    r &= same;
+  }
+
+  // parallel construction gives the same tables
+  {
+    walker::random_choice_bank<> bankp(weights_list, 3);
+    bool same = true;
+    for (std::size_t k = 0; k < bank.size(); ++k) {
+      std::mt19937 e0(k), e1(k);
+      for (int t = 0; t < 1000; ++t) same &= (bank(k, e0) == bankp(k, e1));
+    }
+    std::cout << "parallel construction: " << (same ? "succeeded" : "failed") << std::endl;
+    r &= same;
+  }
+
+  // rebuild a table with new weights of the same padded size, leaving the others intact
+  {
+    std::vector<double> weights(60);
+    for (auto& w : weights) w = dist(eng);
+    bank.rebuild(40, weights);
+    r &= bank.check(40, weights) && bank.check(39, weights_list[39]) &&
+      bank.check(41, weights_list[41]);
+    r &= chi_square_test("rebuilt table 40", bank, 40, eng, weights);
+    bool thrown = false;
+    try { bank.rebuild(40, std::vector<double>(65, 1.0)); } catch (std::invalid_argument const&) { thrown = true; }
+    if (!thrown) {
+      std::cout << "exception expected\n";
+      r = false;
+    }
+  }
+
+  if (r) {
+    std::cout << "check succeeded\n";
+  } else {
+    std::cout << "check failed\n";
+    std::exit(-1);
+  }
+}
+catch (const std::exception& excp) {
+  std::cerr << excp.what() << std::endl;
+  std::exit(-1); }
+catch (...) {
+  std::cerr << "Unknown exception occurred!" << std::endl;
+  std::exit(-1); }
+}
@@ -0,0 +1,95 @@
+/*
+   Copyright (C) 2022 by Synge Todo <wistaria@phys.s.u-tokyo.ac.jp>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include <iostream>
+#include <random>
+#include <vector>
+#include "walker/random_choice.hpp"
+
+static const unsigned int n = 9;
+static const unsigned int samples = 100003;
+
+// uniform real number generator in [0,1)
+template<class Engine>
+struct uniform_01 {
+  uniform_01(Engine const& eng) : eng_(eng) {}
+  double operator()() { return dist_(eng_); }
+  Engine eng_;
+  std::uniform_real_distribution<> dist_;
+};
+
+// batched samples must coincide with those of repeated calls of operator()
+template<class RC, class Engine>
+bool compare(RC const& rc, Engine& eng) {
+  Engine eng_ref = eng;
+  std::vector<unsigned int> ref(samples), batch(samples);
+  for (auto& x : ref) x = rc(eng_ref);
+  rc.generate(eng, batch.data(), batch.data() + samples);
+  return ref == batch;
+}
+
+int main() {
+try {
+  std::cout << "number of bins = " << n << std::endl;
+  std::cout << "number of samples = " << samples << std::endl;
+
+  std::vector<double> weights(n);
+
+  // random number generator
+  typedef std::mt19937 engine_type;
+  engine_type eng(29411);
+  std::uniform_real_distribution<> dist;
+
+  // generate weights
+  for (auto& w : weights) w = dist(eng);
+
+  walker::random_choice<double> rc_double(weights);
+  walker::random_choice<engine_type> rc_int(weights);
+
+  const walker::detail::simd_isa best = walker::detail::simd_level();
+  for (auto isa : { walker::detail::simd_isa::scalar, walker::detail::simd_isa::avx2,
+                    walker::detail::simd_isa::avx512 }) {
+    if (isa > best) continue;
+    walker::detail::simd_level() = isa;
+    std::cout << "instruction set = " << int(isa) << std::endl;
+
+    // double-base version
+    uniform_01<engine_type> u01(eng);
+    if (compare(rc_double, u01)) {
+      std::cout << "double-base version: check succeeded\n";
+    } else {
+      std::cout << "double-base version: check failed\n";
+      std::exit(-1);
+    }
+
+    // integer-base version
+    engine_type eng_int(eng);
+    if (compare(rc_int, eng_int)) {
+      std::cout << "integer-base version: check succeeded\n";
+    } else {
+      std::cout << "integer-base version: check failed\n";
+      std::exit(-1);
+    }
+  }
+  walker::detail::simd_level() = best;
+}
+catch (const std::exception& excp) {
+  std::cerr << excp.what() << std::endl;
+  std::exit(-1); }
+catch (...) {
+  std::cerr << "Unknown exception occurred!" << std::endl;
+  std::exit(-1); }
+}
@@ -0,0 +1,119 @@
+/*
+   Copyright (C) 2022 by Synge Todo <wistaria@phys.s.u-tokyo.ac.jp>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+// Chi-square test of random_choice_blocked (two-level alias table) with
+// block sizes that do and do not divide N, blocks of zero weight, and
+// 32-bit and 64-bit engines
+
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "walker/random_choice.hpp"
+
+static const unsigned int samples = 10000000;
+
+// 8-bit engine, too narrow for tables of more than 256 entries
+class engine8 {
+public:
+  typedef std::uint32_t result_type;
+  static constexpr result_type min() { return 0; }
+  static constexpr result_type max() { return 255; }
+  result_type operator()() { return 0; }
+};
+
+template<class RC, class Engine>
+bool chi_square_test(std::string const& name, RC const& rc, Engine& eng,
+                     std::vector<double> const& weights) {
+  std::size_t n = weights.size();
+  double tw = 0;
+  for (auto w : weights) tw += w;
+  std::vector<double> accum(n, 0);
+  for (unsigned int t = 0; t < samples; ++t) ++accum[rc(eng)];
+  double chi2 = 0;
+  std::size_t dof = 0;
+  bool zeros = true;
+  for (std::size_t i = 0; i < n; ++i) {
+    if (weights[i] > 0) {
+      double expected = samples * weights[i] / tw;
+      chi2 += (accum[i] - expected) * (accum[i] - expected) / expected;
+      ++dof;
+    } else {
+      zeros &= (accum[i] == 0);
+    }
+  }
+  // accept up to 5 standard deviations of the chi-square distribution
+  dof -= 1;
+  double limit = dof + 5 * std::sqrt(2.0 * dof);
+  std::cout << name << ": chi2 = " << chi2 << " (dof = " << dof << ", limit = " << limit
+            << ")" << (zeros ? "" : ", zero-weight bin sampled") << std::endl;
+  return zeros && chi2 < limit;
+}
+
+int main() {
+try {
+  std::mt19937 eng32(29411);
+  std::mt19937_64 eng64(29411);
+  std::uniform_real_distribution<> dist;
+
+  bool r = true;
+  for (std::size_t n : { 1000, 1024, 5003 }) {
+    std::vector<double> weights(n);
+    for (auto& w : weights) w = dist(eng64);
+    // two blocks of 32 bins with zero weight
+    for (std::size_t i = 64; i < 128; ++i) weights[i] = 0;
+    for (int log2_block : { 1, 5, 9 }) {
+      std::cout << "number of bins = " << n << ", block size = " << (1 << log2_block) << std::endl;
+      walker::detail::random_choice_blocked<> rc(weights, log2_block);
+      if (!rc.check(weights)) {
+        std::cout << "table check failed\n";
+        r = false;
+      }
+      rc.check_engine<std::mt19937>();
+      bool thrown = false;
+      try { rc.check_engine<engine8>(); } catch (std::range_error&) { thrown = true; }
+      r &= thrown;
+      r &= chi_square_test("32-bit engine", rc, eng32, weights);
+      walker::detail::random_choice_blocked<std::uint64_t, std::uint64_t> rc64(weights, log2_block);
+      r &= chi_square_test("64-bit engine", rc64, eng64, weights);
+
+      // parallel construction gives the same table
+      walker::detail::random_choice_blocked<> rcp(weights, log2_block, 3);
+      std::mt19937 e0(1), e1(1);
+      bool same = true;
+      for (int t = 0; t < 10000; ++t) same &= (rc(e0) == rcp(e1));
+      std::cout << "parallel construction: " << (same ? "succeeded" : "failed") << std::endl;
+      r &= same;
+    }
+  }
+
+  if (r) {
+    std::cout << "check succeeded\n";
+  } else {
+    std::cout << "check failed\n";
+    std::exit(-1);
+  }
+}
+catch (const std::exception& excp) {
+  std::cerr << excp.what() << std::endl;
+  std::exit(-1); }
+catch (...) {
+  std::cerr << "Unknown exception occurred!" << std::endl;
+  std::exit(-1); }
+}
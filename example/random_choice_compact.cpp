@@ -0,0 +1,84 @@
+/*
+   Copyright (C) 2022 by Synge Todo <wistaria@phys.s.u-tokyo.ac.jp>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "walker/random_choice.hpp"
+
+static const unsigned int n = 9;
+static const unsigned int samples = 100000;
+
+template<class Width, class Engine>
+void test(std::string const& name, std::vector<double> const& weights, Engine& eng) {
+  double tw = 0;
+  for (unsigned int i = 0; i < n; ++i) tw += weights[i];
+
+  walker::random_choice_compact<Width> rc(weights);
+  std::cout << name << ": " << Width::entry_bytes() << " bytes per entry, max bias = "
+            << Width::max_bias() << std::endl;
+
+  // check
+  if (rc.check(weights, Width::max_bias())) {
+    std::cout << "check succeeded\n";
+  } else {
+    std::cout << "check failed\n";
+    std::exit(-1);
+  }
+
+  std::vector<double> accum(n, 0);
+  for (unsigned int t = 0; t < samples; ++t) ++accum[rc(eng)];
+
+  std::cout << "bin\tweight\t\tresult\t\tdiff\t\tsigma\t\tdiff/sigma\n";
+  for (unsigned int i = 0; i < n; ++i) {
+    double diff = std::abs((weights[i] / tw) - (accum[i] / samples));
+    double sigma = std::sqrt(accum[i]) / samples;
+    std::cout << i << "\t" << (weights[i] / tw) << "    \t"
+              << (accum[i] / samples) << "    \t" << diff << "    \t"
+              << sigma << "    \t" << (diff / sigma) << std::endl;
+  }
+}
+
+int main() {
+try {
+  std::cout << "number of bins = " << n << std::endl;
+  std::cout << "number of samples = " << samples << std::endl;
+
+  std::vector<double> weights(n);
+
+  // random number generator
+  typedef std::mt19937 engine_type;
+  engine_type eng(29411);
+  std::uniform_real_distribution<> dist;
+  auto u01 = [&]() { return dist(eng); };
+
+  // generate weights
+  for (auto& w : weights) w = dist(eng);
+
+  test<walker::width_u16>("16-bit cutoff, 16-bit alias", weights, eng);
+  test<walker::width_u32>("32-bit cutoff, 32-bit alias", weights, eng);
+  test<walker::width_f32>("float cutoff, 32-bit alias", weights, u01);
+  test<walker::width_f64>("double cutoff, 32-bit alias", weights, u01);
+}
+catch (const std::exception& excp) {
+  std::cerr << excp.what() << std::endl;
+  std::exit(-1); }
+catch (...) {
+  std::cerr << "Unknown exception occurred!" << std::endl;
+  std::exit(-1); }
+}
@@ -0,0 +1,111 @@
+/*
+   Copyright (C) 2022 by Synge Todo <wistaria@phys.s.u-tokyo.ac.jp>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+
+// Chi-square test of random_choice_multiply, which keeps exactly N table
+// entries (no padding to a power of two), with 32-bit and 64-bit engines
+
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "walker/random_choice.hpp"
+
+static const unsigned int samples = 10000000;
+
+template<class RC, class Engine>
+bool chi_square_test(std::string const& name, RC const& rc, Engine& eng,
+                     std::vector<double> const& weights) {
+  std::size_t n = weights.size();
+  double tw = 0;
+  for (auto w : weights) tw += w;
+  std::vector<double> accum(n, 0);
+  for (unsigned int t = 0; t < samples; ++t) ++accum[rc(eng)];
+  double chi2 = 0;
+  for (std::size_t i = 0; i < n; ++i) {
+    double expected = samples * weights[i] / tw;
+    chi2 += (accum[i] - expected) * (accum[i] - expected) / expected;
+  }
+  // accept up to 5 standard deviations of the chi-square distribution
+  double dof = n - 1;
+  double limit = dof + 5 * std::sqrt(2 * dof);
+  std::cout << name << ": chi2 = " << chi2 << " (dof = " << dof << ", limit = " << limit << ")\n";
+  return chi2 < limit;
+}
+
+// 8-bit engine enumerating all the words, for which the rejection of
+// 256 mod n words is essential
+class engine8 {
+public:
+  typedef unsigned int result_type;
+  static constexpr result_type min() { return 0; }
+  static constexpr result_type max() { return 255; }
+  result_type operator()() { return (state_ = (state_ + 1) & 255); }
+private:
+  result_type state_ = 0;
+};
+
+int main() {
+try {
+  std::mt19937 eng32(29411);
+  std::mt19937_64 eng64(29411);
+  std::uniform_real_distribution<> dist;
+
+  bool r = true;
+  for (std::size_t n : { 9, 1025 }) {
+    std::cout << "number of bins = " << n << std::endl;
+    std::vector<double> weights(n);
+    for (auto& w : weights) w = dist(eng64);
+    walker::detail::random_choice_multiply<> rc(weights);
+    if (!rc.check(weights)) {
+      std::cout << "table check failed\n";
+      r = false;
+    }
+    // no padding to a power of two
+    r &= (rc.table_bytes() == n * 2 * sizeof(std::uint32_t));
+    r &= chi_square_test("32-bit engine", rc, eng32, weights);
+    r &= chi_square_test("64-bit engine", rc, eng64, weights);
+  }
+
+  // each value of [0, n) is obtained from exactly floor(256 / n) words
+  {
+    const std::uint64_t n = 37;
+    engine8 eng;
+    std::vector<unsigned int> count(n, 0);
+    for (unsigned int t = 0; t < 256 / n; ++t)
+      for (unsigned int i = 0; i < n; ++i) ++count[walker::detail::reduce_range(eng, n)];
+    bool uniform = true;
+    for (auto c : count) uniform &= (c == 256 / n);
+    std::cout << "exhaustive reduction test: " << (uniform ? "succeeded" : "failed") << std::endl;
+    r &= uniform;
+  }
+
+  if (r) {
+    std::cout << "check succeeded\n";
+  } else {
+    std::cout << "check failed\n";
+    std::exit(-1);
+  }
+}
+catch (const std::exception& excp) {
+  std::cerr << excp.what() << std::endl;
+  std::exit(-1); }
+catch (...) {
+  std::cerr << "Unknown exception occurred!" << std::endl;
+  std::exit(-1); }
+}
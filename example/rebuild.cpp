@@ -0,0 +1,92 @@
+/*
+   Copyright (C) 2022 by Synge Todo <wistaria@phys.s.u-tokyo.ac.jp>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+#include "walker/random_choice.hpp"
+
+// count memory allocations
+static std::size_t allocations = 0;
+void* operator new(std::size_t size) {
+  ++allocations;
+  if (void* p = std::malloc(size ? size : 1)) return p;
+  throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+template<class RC, class Engine>
+void test(std::string const& name) {
+  std::mt19937 eng(29411);
+  std::uniform_real_distribution<> dist;
+  std::vector<double> weights(1000);
+  RC rc(std::vector<double>(1, 1.0));
+  typename RC::workspace_type work;
+  for (int sweep = 0; sweep < 4; ++sweep) {
+    for (unsigned int n : { 1000u, 17u, 600u, 1u }) {
+      weights.resize(n);
+      for (auto& w : weights) w = dist(eng);
+      std::size_t before = allocations;
+      if (sweep % 2 == 0)
+        rc.rebuild(weights);
+      else
+        rc.rebuild(weights, work);
+      // steady state: the table and the work array are large enough
+      if (sweep >= 2 && allocations != before) {
+        std::cout << name << ": rebuild allocated memory for n = " << n << std::endl;
+        std::exit(-1);
+      }
+      if (!rc.check(weights, 1e-8)) {
+        std::cout << name << ": check failed for n = " << n << std::endl;
+        std::exit(-1);
+      }
+      // same table as a newly constructed one
+      RC fresh(weights);
+      Engine e1(sweep), e2(sweep);
+      for (int t = 0; t < 1000; ++t) {
+        if (rc(e1) != fresh(e2)) {
+          std::cout << name << ": rebuilt table differs for n = " << n << std::endl;
+          std::exit(-1);
+        }
+      }
+    }
+  }
+  std::cout << name << ": check succeeded\n";
+}
+
+// returns random numbers in [0,1)
+struct uniform_01 {
+  std::mt19937 eng;
+  explicit uniform_01(unsigned int seed) : eng(seed) {}
+  double operator()() { return std::uniform_real_distribution<>()(eng); }
+};
+
+int main() {
+try {
+  test<walker::random_choice<std::mt19937>, std::mt19937>("integer-base");
+  test<walker::random_choice_compact<walker::width_f64>, uniform_01>("double-base");
+}
+catch (const std::exception& excp) {
+  std::cerr << excp.what() << std::endl;
+  std::exit(-1); }
+catch (...) {
+  std::cerr << "Unknown exception occurred!" << std::endl;
+  std::exit(-1); }
+}
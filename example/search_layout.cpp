@@ -0,0 +1,113 @@
+/*
+   Copyright (C) 2022 by Synge Todo <wistaria@phys.s.u-tokyo.ac.jp>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+#include "walker/random_choice.hpp"
+#include "walker/tower_sampling.hpp"
+
+// Eytzinger-ordered search and guide-table search must return exactly what
+// std::upper_bound returns on the sorted cumulative weights
+
+typedef std::mt19937 engine_type;
+
+// returns the given value as a "random number"
+struct fixed {
+  typedef double result_type;
+  double p;
+  double operator()() const { return p; }
+};
+
+bool test(std::vector<double> const& weights, engine_type& eng) {
+  unsigned int n = weights.size();
+  walker::detail::random_choice_eytzinger<> rc(weights);
+  walker::detail::random_choice_guide<> rg1(weights);
+  walker::detail::random_choice_guide<> rg4(weights, 0.25);
+  double norm = 0;
+  for (auto w : weights) norm += w;
+  std::vector<double> accum;
+  double a = 0;
+  for (auto w : weights) {
+    a += w / norm;
+    accum.push_back(a);
+  }
+
+  // random points, the cumulative weights themselves, and the boundaries
+  std::uniform_real_distribution<> dist;
+  std::vector<double> points(accum);
+  for (unsigned int t = 0; t < 10 * n + 100; ++t) points.push_back(dist(eng));
+  points.push_back(0);
+  points.push_back(std::nextafter(1.0, 0.0));
+  for (auto p : points) {
+    unsigned int expected = std::min<unsigned int>(
+      std::upper_bound(accum.begin(), accum.end(), p) - accum.begin(), n - 1);
+    fixed f = { p };
+    if (rc(f) != expected) {
+      std::cout << "mismatch for n = " << n << ", p = " << p << ": "
+                << rc(f) << " != " << expected << std::endl;
+      return false;
+    }
+    if (p < accum.back() && (rg1(f) != expected || rg4(f) != expected)) {
+      std::cout << "guide mismatch for n = " << n << ", p = " << p << ": "
+                << rg1(f) << ", " << rg4(f) << " != " << expected << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+int main() {
+try {
+  engine_type eng(29411);
+  std::uniform_real_distribution<> dist;
+  bool ok = true;
+  for (unsigned int n = 1; n <= 200; ++n) {
+    std::vector<double> weights(n);
+    for (auto& w : weights) w = dist(eng);
+    ok &= test(weights, eng);
+    // zero weights at both ends and in between
+    for (unsigned int i = 0; i < n; i += 3) weights[i] = 0;
+    weights[n - 1] = 0;
+    weights[n / 2] = 1;
+    ok &= test(weights, eng);
+  }
+  std::cout << "random_choice_eytzinger, random_choice_guide: " << (ok ? "succeeded" : "failed") << std::endl;
+  if (!ok) std::exit(-1);
+
+  // tower_sampling never returns bins of zero weight, nor out of range
+  std::vector<double> weights = { 0, 1, 0, 2, 0 };
+  walker::tower_sampling<> ts(weights.begin(), weights.end());
+  std::vector<unsigned int> count(weights.size(), 0);
+  for (unsigned int t = 0; t < 100000; ++t) {
+    int x = ts(eng);
+    if (x < 0 || x >= int(weights.size()) || weights[x] == 0) {
+      std::cout << "tower_sampling: invalid result " << x << std::endl;
+      std::exit(-1);
+    }
+    ++count[x];
+  }
+  std::cout << "tower_sampling: " << count[1] << ' ' << count[3] << std::endl;
+}
+catch (const std::exception& excp) {
+  std::cerr << excp.what() << std::endl;
+  std::exit(-1); }
+catch (...) {
+  std::cerr << "Unknown exception occurred!" << std::endl;
+  std::exit(-1); }
+}
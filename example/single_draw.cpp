@@ -0,0 +1,81 @@
+/*
+   Copyright (C) 2022 by Synge Todo <wistaria@phys.s.u-tokyo.ac.jp>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+// Chi-square test of single_draw(), which derives both the bin and the
+// cutoff comparator from one 64-bit random word
+
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "walker/random_choice.hpp"
+
+static const unsigned int n = 37;
+static const unsigned int samples = 10000000;
+
+template<class RC, class Engine>
+bool chi_square_test(std::string const& name, RC const& rc, Engine& eng,
+                     std::vector<double> const& weights) {
+  double tw = 0;
+  for (auto w : weights) tw += w;
+  std::vector<double> accum(n, 0);
+  for (unsigned int t = 0; t < samples; ++t) ++accum[rc.single_draw(eng)];
+  double chi2 = 0;
+  for (unsigned int i = 0; i < n; ++i) {
+    double expected = samples * weights[i] / tw;
+    chi2 += (accum[i] - expected) * (accum[i] - expected) / expected;
+  }
+  // accept up to 5 standard deviations of the chi-square distribution
+  double dof = n - 1;
+  double limit = dof + 5 * std::sqrt(2 * dof);
+  std::cout << name << ": chi2 = " << chi2 << " (dof = " << dof << ", limit = " << limit << ")\n";
+  return chi2 < limit;
+}
+
+int main() {
+try {
+  std::cout << "number of bins = " << n << std::endl;
+  std::cout << "number of samples = " << samples << std::endl;
+
+  std::vector<double> weights(n);
+
+  // random number generator
+  typedef std::mt19937_64 engine_type;
+  engine_type eng(29411);
+  std::uniform_real_distribution<> dist;
+
+  // generate weights
+  for (auto& w : weights) w = dist(eng);
+
+  bool r = true;
+  r &= chi_square_test("double-base version", walker::random_choice<double>(weights), eng, weights);
+  r &= chi_square_test("integer-base version", walker::random_choice<unsigned int>(weights), eng, weights);
+  r &= chi_square_test("packed-table version", walker::detail::random_choice_packed<>(weights), eng, weights);
+  if (r) {
+    std::cout << "check succeeded\n";
+  } else {
+    std::cout << "check failed\n";
+    std::exit(-1);
+  }
+}
+catch (const std::exception& excp) {
+  std::cerr << excp.what() << std::endl;
+  std::exit(-1); }
+catch (...) {
+  std::cerr << "Unknown exception occurred!" << std::endl;
+  std::exit(-1); }
+}
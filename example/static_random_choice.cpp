@@ -0,0 +1,91 @@
+/*
+   Copyright (C) 2022 by Synge Todo <wistaria@phys.s.u-tokyo.ac.jp>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+#include "walker/static_random_choice.hpp"
+
+static const unsigned int n = 6;
+static const unsigned int samples = 100000;
+
+// table computed at compile time
+static constexpr std::array<double, n> weights = { 0.5, 1.0, 0.0, 2.5, 0.25, 1.75 };
+static constexpr walker::static_random_choice<n> rc(weights);
+static_assert(rc.table_size == 8, "unexpected table size");
+static_assert(rc.table()[2].first < rc.table()[3].first, "empty bin must always take its alias");
+
+int main() {
+try {
+  std::cout << "number of bins = " << n << std::endl;
+  std::cout << "number of samples = " << samples << std::endl;
+  double tw = 0;
+  for (unsigned int i = 0; i < n; ++i) tw += weights[i];
+
+  // check
+  if (rc.check(weights, 4.0e-9)) {
+    std::cout << "check succeeded\n";
+  } else {
+    std::cout << "check failed\n";
+    std::exit(-1);
+  }
+
+  // the same table is obtained at runtime
+  walker::static_random_choice<n> rt(weights);
+  for (std::size_t i = 0; i < rc.table_size; ++i) {
+    if (rt.table()[i] != rc.table()[i]) {
+      std::cout << "table mismatch at " << i << std::endl;
+      std::exit(-1);
+    }
+  }
+
+  // random number generators of 32-bit and 64-bit words
+  std::mt19937 eng(29411);
+  std::mt19937_64 eng64(29411);
+
+  std::vector<double> accum(n, 0), accum64(n, 0);
+  for (unsigned int t = 0; t < samples; ++t) ++accum[rc(eng)];
+  for (unsigned int t = 0; t < samples; ++t) {
+    unsigned int x = rc(eng64);
+    if (x >= n) {
+      std::cout << "sample out of range with 64-bit engine: " << x << std::endl;
+      std::exit(-1);
+    }
+    ++accum64[x];
+  }
+
+  std::cout << "bin\tweight\t\tresult\t\tdiff\t\tsigma\t\tdiff/sigma\tresult(64-bit)\n";
+  for (unsigned int i = 0; i < n; ++i) {
+    double diff = std::abs((weights[i] / tw) - (accum[i] / samples));
+    double sigma = std::sqrt(accum[i]) / samples;
+    std::cout << i << "\t" << (weights[i] / tw) << "    \t"
+              << (accum[i] / samples) << "    \t" << diff << "    \t"
+              << sigma << "    \t" << (diff / sigma) << "    \t"
+              << (accum64[i] / samples) << std::endl;
+  }
+  if (accum64[2] != 0) {
+    std::cout << "empty bin drawn with 64-bit engine\n";
+    std::exit(-1);
+  }
+}
+catch (const std::exception& excp) {
+  std::cerr << excp.what() << std::endl;
+  std::exit(-1); }
+catch (...) {
+  std::cerr << "Unknown exception occurred!" << std::endl;
+  std::exit(-1); }
+}
@@ -0,0 +1,141 @@
+/*
+   Copyright (C) 2022 by Synge Todo <wistaria@phys.s.u-tokyo.ac.jp>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "walker/subset_sampling.hpp"
+
+static const unsigned int n = 9;
+static const unsigned int k = 2;
+static const unsigned int samples = 100000;
+
+template<class SAMPLE>
+void test(std::string const& name, std::vector<double> const& weights,
+          std::vector<double> const& prob, SAMPLE const& sample) {
+  std::cout << name << std::endl;
+  std::vector<double> accum(n, 0);
+  std::vector<unsigned int> subset;
+  for (unsigned int t = 0; t < samples; ++t) {
+    subset.clear();
+    sample(std::back_inserter(subset));
+    if (subset.size() != k || subset[0] == subset[1] || weights[subset[0]] == 0 ||
+        weights[subset[1]] == 0) {
+      std::cout << "invalid subset\n";
+      std::exit(-1);
+    }
+    for (auto i : subset) ++accum[i];
+  }
+
+  // inclusion probabilities
+  std::cout << "bin\tprob\t\tresult\t\tdiff\t\tsigma\t\tdiff/sigma\n";
+  for (unsigned int i = 0; i < n; ++i) {
+    double diff = std::abs(prob[i] - (accum[i] / samples));
+    double sigma = std::sqrt(accum[i]) / samples;
+    std::cout << i << "\t" << prob[i] << "    \t"
+              << (accum[i] / samples) << "    \t" << diff << "    \t"
+              << sigma << "    \t" << (diff / sigma) << std::endl;
+    if (diff > 5 * sigma + 1e-12) {
+      std::cout << "inclusion probability mismatch\n";
+      std::exit(-1);
+    }
+  }
+}
+
+int main() {
+try {
+  std::cout << "number of bins = " << n << std::endl;
+  std::cout << "number of elements to draw = " << k << std::endl;
+  std::cout << "number of samples = " << samples << std::endl;
+
+  std::vector<double> weights(n);
+
+  // random number generator
+  typedef std::mt19937 engine_type;
+  engine_type eng(29411);
+  std::uniform_real_distribution<> dist;
+
+  // generate weights
+  for (auto& w : weights) w = dist(eng);
+  weights[4] = 0;
+  double tw = 0;
+  for (unsigned int i = 0; i < n; ++i) tw += weights[i];
+
+  // exact inclusion probabilities for k = 2
+  std::vector<double> prob(n, 0);
+  for (unsigned int i = 0; i < n; ++i) {
+    prob[i] = weights[i] / tw;
+    for (unsigned int j = 0; j < n; ++j)
+      if (j != i) prob[i] += (weights[j] / tw) * weights[i] / (tw - weights[j]);
+  }
+
+  walker::subset_sampling<unsigned int> ss(weights.begin(), weights.end());
+  test("sum tree with removal", weights, prob,
+       [&](std::back_insert_iterator<std::vector<unsigned int>> out) { ss.sample_tree(eng, k, out); });
+  test("exponential keys", weights, prob,
+       [&](std::back_insert_iterator<std::vector<unsigned int>> out) { ss.sample_keys(eng, k, out); });
+  test("alias table with rejection", weights, prob,
+       [&](std::back_insert_iterator<std::vector<unsigned int>> out) { ss(eng, k, out); });
+
+  // all the elements with positive weight
+  std::vector<unsigned int> all;
+  ss(eng, ss.positives(), std::back_inserter(all));
+  std::vector<int> count(n, 0);
+  for (auto i : all) ++count[i];
+  for (unsigned int i = 0; i < n; ++i) {
+    if (count[i] != (weights[i] > 0 ? 1 : 0)) {
+      std::cout << "failed to draw all the elements\n";
+      std::exit(-1);
+    }
+  }
+
+  // large k from a large tree, where the partial sums are overridden in
+  // the hash table instead of a copy of the tree
+  const unsigned int n_large = 1 << 16;
+  const unsigned int k_large = 400;
+  std::vector<double> weights_large(n_large);
+  for (unsigned int i = 0; i < n_large; ++i) weights_large[i] = (i % 3 == 0) ? 0 : dist(eng);
+  walker::subset_sampling<unsigned int> ss_large(weights_large.begin(), weights_large.end());
+  std::vector<char> taken(n_large, 0);
+  for (unsigned int t = 0; t < 10; ++t) {
+    std::vector<unsigned int> subset;
+    ss_large.sample_tree(eng, k_large, std::back_inserter(subset));
+    if (subset.size() != k_large) {
+      std::cout << "invalid subset size for large k\n";
+      std::exit(-1);
+    }
+    std::fill(taken.begin(), taken.end(), 0);
+    for (auto i : subset) {
+      if (i >= n_large || weights_large[i] == 0 || taken[i]) {
+        std::cout << "invalid subset for large k\n";
+        std::exit(-1);
+      }
+      taken[i] = 1;
+    }
+  }
+  std::cout << "check succeeded\n";
+}
+catch (const std::exception& excp) {
+  std::cerr << excp.what() << std::endl;
+  std::exit(-1); }
+catch (...) {
+  std::cerr << "Unknown exception occurred!" << std::endl;
+  std::exit(-1); }
+}
@@ -0,0 +1,78 @@
+/*
+   Copyright (C) 2022 by Synge Todo <wistaria@phys.s.u-tokyo.ac.jp>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+#include "walker/sum_tree_sampling.hpp"
+
+static const unsigned int n = 9;
+static const unsigned int samples = 100000;
+
+template<class RC, class Engine>
+void sample(RC const& rc, Engine& eng, std::vector<double> const& weights) {
+  double tw = 0;
+  for (unsigned int i = 0; i < n; ++i) tw += weights[i];
+
+  std::vector<double> accum(n, 0);
+  for (unsigned int t = 0; t < samples; ++t) ++accum[rc(eng)];
+
+  std::cout << "bin\tweight\t\tresult\t\tdiff\t\tsigma\t\tdiff/sigma\n";
+  for (unsigned int i = 0; i < n; ++i) {
+    double diff = std::abs((weights[i] / tw) - (accum[i] / samples));
+    double sigma = std::sqrt(accum[i]) / samples;
+    std::cout << i << "\t" << (weights[i] / tw) << "    \t"
+              << (accum[i] / samples) << "    \t" << diff << "    \t"
+              << sigma << "    \t" << (diff / sigma) << std::endl;
+  }
+}
+
+int main() {
+try {
+  std::cout << "number of bins = " << n << std::endl;
+  std::cout << "number of samples = " << samples << std::endl;
+
+  std::vector<double> weights(n);
+
+  // random number generator
+  typedef std::mt19937 engine_type;
+  engine_type eng(29411);
+  std::uniform_real_distribution<> dist;
+
+  // generate weights
+  for (auto& w : weights) w = dist(eng);
+
+  walker::sum_tree_sampling<> rc(weights.begin(), weights.end());
+  sample(rc, eng, weights);
+
+  // update some weights
+  weights[0] = 0;
+  weights[3] *= 3;
+  weights[n - 1] = 2;
+  rc.update(0, weights[0]);
+  rc.update(3, weights[3]);
+  rc.update(n - 1, weights[n - 1]);
+  std::cout << "after update\n";
+  sample(rc, eng, weights);
+}
+catch (const std::exception& excp) {
+  std::cerr << excp.what() << std::endl;
+  std::exit(-1); }
+catch (...) {
+  std::cerr << "Unknown exception occurred!" << std::endl;
+  std::exit(-1); }
+}
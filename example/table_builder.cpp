@@ -0,0 +1,139 @@
+/*
+   Copyright (C) 2022 by Synge Todo <wistaria@phys.s.u-tokyo.ac.jp>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+// Build tables from a weights file in bounded memory and compare them
+// with the reference tables built in memory by fill_ft2009
+
+#include <cmath>
+#include <cstdio>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "walker/random_choice.hpp"
+#include "walker/table_builder.hpp"
+
+static const unsigned int n = 5000;
+
+// probability of each bin represented by a table, in O(N)
+template<class TABLE>
+std::vector<double> bin_probabilities(TABLE const& table, std::size_t n) {
+  typedef typename TABLE::value_type::first_type cutoff_type;
+  double nm = 1;
+  if (std::is_integral<cutoff_type>::value) nm /= std::numeric_limits<cutoff_type>::max();
+  std::vector<double> p(table.size(), 0);
+  for (std::size_t k = 0; k < table.size(); ++k) {
+    p[k] += nm * table[k].first;
+    p[table[k].second] += 1 - nm * table[k].first;
+  }
+  for (auto& x : p) x /= table.size();
+  p.resize(n);
+  return p;
+}
+
+template<class CutoffType, class IndexType, class SOURCE>
+bool test(std::string const& name, SOURCE const& source, std::vector<double> const& weights,
+          double tol) {
+  std::string file = "table_builder.bin";
+  std::uint64_t m = walker::build_table<CutoffType, IndexType>(source, file);
+
+  // reference
+  std::vector<std::pair<CutoffType, IndexType> > ref;
+  walker::detail::fill_ft2009(weights, ref);
+
+  walker::detail::table_storage<std::pair<CutoffType, IndexType> > table;
+  walker::detail::load_table<CutoffType, IndexType>(file, walker::detail::table_kind::walker, table);
+  bool r = (m == ref.size() && table.size() == ref.size());
+  r &= walker::detail::check_table(weights, table, tol);
+  auto p = bin_probabilities(table, weights.size());
+  auto q = bin_probabilities(ref, weights.size());
+  double diff = 0;
+  for (std::size_t i = 0; i < weights.size(); ++i) diff = std::max(diff, std::abs(p[i] - q[i]));
+  r &= diff < tol;
+  for (std::size_t i = 0; i < weights.size(); ++i) r &= (weights[i] > 0 || p[i] == 0);
+
+  // the file is used by the sampler as is
+  walker::detail::random_choice_walker<CutoffType, IndexType, double> rc;
+  rc.load(file);
+  r &= rc.check(weights, tol);
+
+  std::cout << name << ": max diff = " << diff << ", "
+            << (r ? "check succeeded" : "check failed") << std::endl;
+  return r;
+}
+
+int main() {
+try {
+  std::cout << "number of bins = " << n << std::endl;
+
+  std::vector<double> weights(n);
+
+  // random number generator
+  typedef std::mt19937 engine_type;
+  engine_type eng(29411);
+  std::uniform_real_distribution<> dist;
+
+  // generate weights, with zeros and a few heavy bins
+  for (auto& w : weights) w = (dist(eng) < 0.2) ? 0 : dist(eng);
+  for (unsigned int i = 0; i < n; i += 97) weights[i] = 100 * dist(eng);
+
+  // weights file
+  std::string weights_file = "table_builder_weights.bin";
+  {
+    std::ofstream os(weights_file, std::ios::binary | std::ios::trunc);
+    os.write(reinterpret_cast<const char*>(weights.data()), sizeof(double) * n);
+  }
+
+  bool r = true;
+  // small chunks so that the reads cross many chunk boundaries
+  walker::weights_file<> source(weights_file, 37);
+  r &= test<double, std::uint64_t>("double cutoff, 64-bit index", source, weights, 1e-12);
+  r &= test<double, std::uint32_t>("double cutoff, 32-bit index", source, weights, 1e-12);
+  r &= test<std::uint32_t, std::uint32_t>("integer cutoff, 32-bit index", source, weights, 1e-8);
+  r &= test<double, std::uint32_t>("iterator source",
+    walker::make_iterator_source(weights.begin(), weights.end()), weights, 1e-12);
+
+  // weights given in single precision
+  {
+    std::vector<float> wf(weights.begin(), weights.end());
+    std::ofstream os(weights_file, std::ios::binary | std::ios::trunc);
+    os.write(reinterpret_cast<const char*>(wf.data()), sizeof(float) * n);
+    os.close();
+    std::vector<double> wd(wf.begin(), wf.end());
+    walker::build_table_file<double, std::uint32_t, float>(weights_file, "table_builder.bin");
+    walker::detail::random_choice_walker<double, std::uint32_t, double> rc;
+    rc.load("table_builder.bin");
+    bool rf = rc.check(wd, 1e-12);
+    std::cout << "float weights file: " << (rf ? "check succeeded" : "check failed") << std::endl;
+    r &= rf;
+  }
+
+  std::remove(weights_file.c_str());
+  std::remove("table_builder.bin");
+  if (!r) std::exit(-1);
+}
+catch (const std::exception& excp) {
+  std::cerr << excp.what() << std::endl;
+  std::exit(-1); }
+catch (...) {
+  std::cerr << "Unknown exception occurred!" << std::endl;
+  std::exit(-1); }
+}
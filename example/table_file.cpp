@@ -0,0 +1,185 @@
+/*
+   Copyright (C) 2022 by Synge Todo <wistaria@phys.s.u-tokyo.ac.jp>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+// Save tables to files, map them back into memory, and compare samples
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+#include "walker/random_choice.hpp"
+
+static const unsigned int n = 1000;
+static const unsigned int samples = 100000;
+
+// uniform real number generator in [0,1)
+template<class Engine>
+struct uniform_01 {
+  uniform_01(Engine const& eng) : eng_(eng) {}
+  double operator()() { return dist_(eng_); }
+  Engine eng_;
+  std::uniform_real_distribution<> dist_;
+};
+
+template<class RC, class Engine>
+bool compare(std::string const& name, std::string const& file, RC const& rc, Engine const& eng) {
+  rc.save(file);
+  RC loaded;
+  loaded.load(file);
+  Engine eng0(eng), eng1(eng);
+  bool r = true;
+  for (unsigned int t = 0; t < samples; ++t) r &= (rc(eng0) == loaded(eng1));
+  std::cout << name << ": " << (r ? "check succeeded" : "check failed") << std::endl;
+  return r;
+}
+
+int main() {
+try {
+  std::cout << "number of bins = " << n << std::endl;
+  std::cout << "number of samples = " << samples << std::endl;
+
+  std::vector<double> weights(n);
+
+  // random number generator
+  typedef std::mt19937 engine_type;
+  engine_type eng(29411);
+  std::uniform_real_distribution<> dist;
+
+  // generate weights
+  for (auto& w : weights) w = dist(eng);
+
+  bool r = true;
+  walker::random_choice<double> rc_double(weights);
+  r &= compare("double-base version", "table_double.bin", rc_double, uniform_01<engine_type>(eng));
+  walker::random_choice<engine_type> rc_int(weights);
+  r &= compare("integer-base version", "table_int.bin", rc_int, eng);
+  walker::detail::random_choice_bsearch<> rc_bsearch(weights);
+  r &= compare("bsearch version", "table_bsearch.bin", rc_bsearch, uniform_01<engine_type>(eng));
+
+  // loaded table passes the check
+  {
+    walker::random_choice<engine_type> loaded;
+    loaded.load("table_int.bin");
+    bool c = loaded.check(weights);
+    std::cout << "loaded table: " << (c ? "check succeeded" : "check failed") << std::endl;
+    r &= c;
+  }
+
+  // loading a table of different type or a corrupted file fails
+  {
+    bool c = false;
+    try {
+      walker::random_choice<double> loaded;
+      loaded.load("table_int.bin");
+    } catch (std::runtime_error& e) {
+      std::cout << "expected error: " << e.what() << std::endl;
+      c = true;
+    }
+    std::fstream fs("table_int.bin", std::ios::in | std::ios::out | std::ios::binary);
+    fs.seekp(100);
+    fs.put('x');
+    fs.close();
+    try {
+      walker::random_choice<engine_type> loaded;
+      loaded.load("table_int.bin");
+      c = false;
+    } catch (std::runtime_error& e) {
+      std::cout << "expected error: " << e.what() << std::endl;
+    }
+    std::cout << "invalid files: " << (c ? "check succeeded" : "check failed") << std::endl;
+    r &= c;
+  }
+
+  // padding bytes of the entries are written as zero
+  {
+    typedef std::pair<double, std::uint32_t> entry_type;
+    std::vector<entry_type> table(4);
+    std::memset(static_cast<void*>(table.data()), 0xff, sizeof(entry_type) * table.size());
+    for (std::size_t i = 0; i < table.size(); ++i) {
+      table[i].first = 1.0;
+      table[i].second = std::uint32_t(i);
+    }
+    walker::detail::save_table<double, std::uint32_t>("table_padding.bin",
+      walker::detail::table_kind::walker, 0, table);
+    std::ifstream is("table_padding.bin", std::ios::binary);
+    std::vector<char> bytes((std::istreambuf_iterator<char>(is)), std::istreambuf_iterator<char>());
+    bool c = bytes.size() == sizeof(walker::detail::table_header) + sizeof(entry_type) * table.size();
+    for (std::size_t i = 0; c && i < table.size(); ++i)
+      for (std::size_t j = 12; j < 16; ++j)
+        c &= (bytes[sizeof(walker::detail::table_header) + 16 * i + j] == 0);
+    walker::random_choice<double> loaded;
+    loaded.load("table_padding.bin");
+    std::cout << "zero padding: " << (c ? "check succeeded" : "check failed") << std::endl;
+    r &= c;
+  }
+
+  // headers and tables that would lead to reads out of range are rejected,
+  // also without verifying the checksum
+  {
+    typedef std::pair<std::uint32_t, std::uint32_t> entry_type;
+    auto rejected = [](std::string const& name) {
+      try {
+        walker::random_choice<engine_type> loaded;
+        loaded.load("table_invalid.bin", false);
+      } catch (std::runtime_error& e) {
+        std::cout << name << ": expected error: " << e.what() << std::endl;
+        return true;
+      }
+      std::cout << name << ": check failed\n";
+      return false;
+    };
+    std::vector<entry_type> table(16, entry_type(0xffffffffu, 0));
+    // number of entries whose size in bytes overflows
+    {
+      auto h = walker::detail::make_table_header<std::uint32_t, std::uint32_t, entry_type>(
+        walker::detail::table_kind::walker, (std::uint64_t(1) << 61) + 2, 4);
+      std::ofstream os("table_invalid.bin", std::ios::binary);
+      os.write(reinterpret_cast<const char*>(&h), sizeof(h));
+      os.write(reinterpret_cast<const char*>(table.data()), sizeof(entry_type) * table.size());
+    }
+    r &= rejected("entries overflow");
+    // alias out of range
+    table[3].first = 0;
+    table[3].second = 16;
+    walker::detail::save_table<std::uint32_t, std::uint32_t>("table_invalid.bin",
+      walker::detail::table_kind::walker, 4, table);
+    r &= rejected("alias out of range");
+    // parameter inconsistent with the table size
+    table[3].second = 15;
+    walker::detail::save_table<std::uint32_t, std::uint32_t>("table_invalid.bin",
+      walker::detail::table_kind::walker, 5, table);
+    r &= rejected("parameter mismatch");
+  }
+
+  std::remove("table_padding.bin");
+  std::remove("table_invalid.bin");
+  std::remove("table_double.bin");
+  std::remove("table_int.bin");
+  std::remove("table_bsearch.bin");
+  if (!r) std::exit(-1);
+}
+catch (const std::exception& excp) {
+  std::cerr << excp.what() << std::endl;
+  std::exit(-1); }
+catch (...) {
+  std::cerr << "Unknown exception occurred!" << std::endl;
+  std::exit(-1); }
+}
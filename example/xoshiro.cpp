@@ -0,0 +1,117 @@
+/*
+   Copyright (C) 2022 by Synge Todo <wistaria@phys.s.u-tokyo.ac.jp>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "walker/random_choice.hpp"
+#include "walker/xoshiro.hpp"
+
+static const unsigned int n = 1000;
+static const unsigned int samples = 1000003;
+
+void report(std::string const& name, bool r) {
+  std::cout << name << ": check " << (r ? "succeeded" : "failed") << std::endl;
+  if (!r) std::exit(-1);
+}
+
+int main() {
+try {
+  std::cout << "number of bins = " << n << std::endl;
+  std::cout << "number of samples = " << samples << std::endl;
+
+  // reference implementation: first word from the state (1, 2, 3, 4)
+  {
+    std::uint64_t s[4] = { 1, 2, 3, 4 };
+    report("known answer", walker::detail::xoshiro256pp_next(s) == 41943041);
+  }
+
+  // the words of lane l are those of xoshiro256++ jumped l times
+  std::vector<std::uint32_t> ref(16 * 100);
+  {
+    std::uint64_t x = walker::xoshiro256pp_x8::default_seed;
+    std::uint64_t s[4];
+    for (auto& v : s) v = walker::detail::splitmix64(x);
+    for (int l = 0; l < 8; ++l) {
+      std::uint64_t t[4] = { s[0], s[1], s[2], s[3] };
+      for (std::size_t i = 0; i < 100; ++i) {
+        std::uint64_t r = walker::detail::xoshiro256pp_next(t);
+        ref[16 * i + 2 * l] = std::uint32_t(r);
+        ref[16 * i + 2 * l + 1] = std::uint32_t(r >> 32);
+      }
+      walker::detail::xoshiro256_jump(s);
+    }
+  }
+
+  // the same words for every instruction set, by operator() and by fill()
+  const walker::detail::simd_isa best = walker::detail::simd_level();
+  for (auto isa : { walker::detail::simd_isa::scalar, walker::detail::simd_isa::avx2,
+                    walker::detail::simd_isa::avx512 }) {
+    if (isa > best) continue;
+    walker::detail::simd_level() = isa;
+    walker::xoshiro256pp_simd eng0;
+    std::vector<std::uint32_t> words(ref.size());
+    for (auto& w : words) w = eng0();
+    bool r = (words == ref);
+    for (std::size_t offset : { 0, 1, 15, 16, 17, 511, 512 }) {
+      walker::xoshiro256pp_simd eng1, eng2;
+      eng1.discard(offset);
+      eng2.discard(offset);
+      std::vector<std::uint32_t> w1(1000), w2(1000);
+      for (auto& w : w1) w = eng1();
+      eng2.fill(w2.data(), w2.data() + w2.size());
+      r &= (w1 == w2);
+      for (int i = 0; i < 1000; ++i) r &= (eng1() == eng2());
+    }
+    report("words (instruction set = " + std::to_string(int(isa)) + ")", r);
+  }
+  walker::detail::simd_level() = best;
+
+  // generate weights
+  std::mt19937 gen(29411);
+  std::uniform_real_distribution<> dist;
+  std::vector<double> weights(n);
+  for (auto& w : weights) w = dist(gen);
+  double tw = 0;
+  for (auto w : weights) tw += w;
+
+  // batched samples coincide with those of operator() and follow the weights
+  walker::random_choice<walker::xoshiro256pp_simd> rc(weights);
+  walker::xoshiro256pp_simd eng0, eng1;
+  std::vector<unsigned int> ref_samples(samples), result(samples);
+  for (auto& x : ref_samples) x = rc(eng0);
+  rc.generate(eng1, result.data(), result.data() + samples);
+  report("batched sampling", result == ref_samples);
+
+  std::vector<double> accum(n, 0);
+  for (auto x : result) ++accum[x];
+  double chi2 = 0;
+  for (unsigned int i = 0; i < n; ++i) {
+    double e = weights[i] / tw * samples;
+    chi2 += (accum[i] - e) * (accum[i] - e) / e;
+  }
+  std::cout << "chi2/dof = " << chi2 / (n - 1) << std::endl;
+  report("distribution", chi2 / (n - 1) < 1.2);
+}
+catch (const std::exception& excp) {
+  std::cerr << excp.what() << std::endl;
+  std::exit(-1); }
+catch (...) {
+  std::cerr << "Unknown exception occurred!" << std::endl;
+  std::exit(-1); }
+}
@@ -0,0 +1,99 @@
+/*
+   Copyright (C) 2022 by Synge Todo <wistaria@phys.s.u-tokyo.ac.jp>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+// Tests of detail::check_table, which verifies that an alias table
+// reproduces the weights, at sizes where an O(N M) check is impractical,
+// and of the tables after a failed rebuild
+
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <stdexcept>
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+#include "walker/random_choice.hpp"
+
+static std::vector<double> make_weights(std::size_t n) {
+  std::mt19937_64 eng(n);
+  std::uniform_real_distribution<> dist;
+  std::vector<double> weights(n);
+  for (auto& w : weights) w = dist(eng);
+  if (n > 1) weights[n / 2] = 0;
+  return weights;
+}
+
+TEST_CASE("check_table accepts valid tables", "[check_table]") {
+  for (std::size_t n : { 1, 2, 1000, 4000037 }) {
+    auto weights = make_weights(n);
+    std::vector<std::pair<std::uint32_t, std::uint32_t> > table32;
+    walker::detail::fill_ft2009(weights, table32);
+    CHECK(walker::detail::check_table(weights, table32, 1e-8));
+    std::vector<std::pair<double, std::uint32_t> > tabled;
+    walker::detail::fill_ft2009(weights, tabled);
+    CHECK(walker::detail::check_table(weights, tabled));
+    std::vector<std::pair<std::uint32_t, std::uint32_t> > tablep;
+    walker::detail::fill_hs2019(weights, tablep, 4);
+    CHECK(walker::detail::check_table(weights, tablep, 1e-8));
+  }
+}
+
+TEST_CASE("check_table rejects broken tables", "[check_table]") {
+  const std::size_t n = 1000003;
+  auto weights = make_weights(n);
+  std::vector<std::pair<std::uint32_t, std::uint32_t> > table;
+  walker::detail::fill_ft2009(weights, table);
+  REQUIRE(walker::detail::check_table(weights, table, 1e-8));
+
+  SECTION("wrong alias") {
+    // an entry whose alias takes more than half of the probability
+    std::size_t j = 0;
+    while (table[j].first >= 0x80000000u || table[j].second == 12345) ++j;
+    table[j].second = 12345;
+    CHECK(!walker::detail::check_table(weights, table, 1e-8));
+  }
+  SECTION("wrong cutoff") {
+    std::size_t j = 0;
+    while (table[j].first <= 0x80000000u || table[j].first == 0xffffffffu) ++j;
+    table[j].first /= 2;
+    CHECK(!walker::detail::check_table(weights, table, 1e-8));
+  }
+  SECTION("alias out of range") {
+    table[n / 3].second = std::uint32_t(table.size());
+    CHECK(!walker::detail::check_table(weights, table, 1e-8));
+  }
+  SECTION("probability in a padding bin") {
+    // the padding bins take the remainder of their own entries
+    table[n].second = std::uint32_t(n);
+    CHECK(!walker::detail::check_table(weights, table, 1e-8));
+  }
+}
+
+TEST_CASE("failed rebuild of a loaded table keeps it usable", "[check_table]") {
+  // the table is a view of the mapped file until a rebuild succeeds
+  const char* file = "check_table_rebuild.bin";
+  auto weights = make_weights(1000);
+  walker::random_choice<std::mt19937> rc(weights);
+  rc.save(file);
+  walker::random_choice<std::mt19937> loaded;
+  loaded.load(file);
+  CHECK_THROWS_AS(loaded.rebuild(std::vector<double>(10, -1.0)), std::invalid_argument);
+  CHECK(loaded.check(weights, 1e-8));
+  std::mt19937 eng(29411);
+  for (int i = 0; i < 1000; ++i) CHECK(loaded(eng) < weights.size());
+  loaded.rebuild(weights);
+  CHECK(loaded.check(weights, 1e-8));
+  std::remove(file);
+}
@@ -0,0 +1,149 @@
+/*
+   Copyright (C) 2022 by Synge Todo <wistaria@phys.s.u-tokyo.ac.jp>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+// Harness for the statistical tests of the samplers.  Samples are drawn
+// by several threads, each with its own engine, and their histogram is
+// compared with the weights by Pearson's chi-square test and the G-test
+// (likelihood ratio).  The statistics are converted to normal deviates
+// by the Wilson-Hilferty approximation, so that one threshold (e.g. 5
+// standard deviations) applies to any number of bins.
+
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <vector>
+#include "walker/random_choice.hpp"
+
+namespace walker {
+namespace test {
+
+// uniform real number generator in [0,1) for the samplers taking real values
+template<class Engine>
+struct uniform_01 {
+  typedef double result_type;
+  uniform_01(Engine const& eng) : eng_(eng) {}
+  double operator()() { return dist_(eng_); }
+  Engine eng_;
+  std::uniform_real_distribution<> dist_;
+};
+template<class Engine>
+uniform_01<Engine> make_uniform_01(Engine const& eng) { return uniform_01<Engine>(eng); }
+
+// Histogram of `samples' draws.  Thread t (t = 0, ..., nthreads - 1; 0:
+// all hardware threads) calls draw(eng, m, counts) with eng =
+// make_engine(t), which adds m draws to `counts' of n bins.  Counts of
+// the threads are summed up at the end.
+template<class MakeEngine, class Draw>
+std::vector<std::uint64_t> histogram(std::size_t n, std::uint64_t samples,
+                                     MakeEngine const& make_engine, Draw const& draw,
+                                     unsigned int nthreads = 0) {
+  if (nthreads == 0) nthreads = detail::default_concurrency();
+  std::vector<std::vector<std::uint64_t> > counts(nthreads);
+  detail::parallel_run(nthreads, [&](unsigned int t) {
+    auto eng = make_engine(t);
+    counts[t].assign(n, 0);
+    draw(eng, samples * (t + 1) / nthreads - samples * t / nthreads, counts[t]);
+  });
+  for (unsigned int t = 1; t < nthreads; ++t)
+    for (std::size_t i = 0; i < n; ++i) counts[0][i] += counts[t][i];
+  return counts[0];
+}
+
+// draw function for samplers returning one bin per call
+template<class Sampler>
+auto single_draws(Sampler const& sampler) {
+  return [&sampler](auto& eng, std::uint64_t m, std::vector<std::uint64_t>& counts) {
+    for (std::uint64_t t = 0; t < m; ++t) {
+      std::size_t x = std::size_t(sampler(eng));
+      if (x >= counts.size()) throw std::range_error("single_draws: bin out of range");
+      ++counts[x];
+    }
+  };
+}
+
+struct gof_result {
+  std::size_t dof;          // number of bins (after pooling) - 1
+  double chi2;              // Pearson's chi-square statistic
+  double g;                 // G statistic, 2 sum O ln(O / E)
+  double z_chi2, z_g;       // normal deviates of the above
+  std::uint64_t zero_hits;  // samples in the bins of zero weight
+  bool passed(double z_max = 5) const { return zero_hits == 0 && z_chi2 < z_max && z_g < z_max; }
+};
+
+// normal deviate of x distributed as chi-square with k degrees of
+// freedom (Wilson and Hilferty 1931)
+inline double wilson_hilferty(double x, std::size_t k) {
+  if (k == 0) return 0;
+  double v = 2.0 / (9.0 * k);
+  return (std::cbrt(x / k) - (1 - v)) / std::sqrt(v);
+}
+
+// Goodness of fit of `counts' to `weights'.  Bins with expected counts
+// below `min_expected' are pooled into one bin (or into the smallest
+// other bin if they are still too few), so that the statistics follow
+// the chi-square distribution.
+template<class CONT>
+gof_result goodness_of_fit(CONT const& weights, std::vector<std::uint64_t> const& counts,
+                           double min_expected = 10) {
+  if (weights.size() != counts.size())
+    throw std::invalid_argument("goodness_of_fit");
+  double tw = 0;
+  std::uint64_t samples = 0;
+  for (std::size_t i = 0; i < weights.size(); ++i) {
+    tw += weights[i];
+    samples += counts[i];
+  }
+  gof_result r = { 0, 0, 0, 0, 0, 0 };
+  std::vector<std::pair<double, double> > bins; // (observed, expected)
+  std::pair<double, double> pooled(0, 0);
+  for (std::size_t i = 0; i < weights.size(); ++i) {
+    if (weights[i] > 0) {
+      double e = samples * (weights[i] / tw);
+      if (e < min_expected) {
+        pooled.first += counts[i];
+        pooled.second += e;
+      } else {
+        bins.emplace_back(double(counts[i]), e);
+      }
+    } else {
+      r.zero_hits += counts[i];
+    }
+  }
+  if (pooled.second > 0) {
+    if (pooled.second < min_expected && !bins.empty()) {
+      auto smallest = std::min_element(bins.begin(), bins.end(), [](auto const& a, auto const& b) {
+        return a.second < b.second; });
+      smallest->first += pooled.first;
+      smallest->second += pooled.second;
+    } else {
+      bins.push_back(pooled);
+    }
+  }
+  for (auto const& b : bins) {
+    r.chi2 += (b.first - b.second) * (b.first - b.second) / b.second;
+    if (b.first > 0) r.g += 2 * b.first * std::log(b.first / b.second);
+  }
+  r.dof = bins.empty() ? 0 : bins.size() - 1;
+  r.z_chi2 = wilson_hilferty(r.chi2, r.dof);
+  r.z_g = wilson_hilferty(r.g, r.dof);
+  return r;
+}
+
+} // end namespace test
+} // end namespace walker
@@ -0,0 +1,216 @@
+/*
+   Copyright (C) 2022 by Synge Todo <wistaria@phys.s.u-tokyo.ac.jp>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+// Statistical tests of the samplers in walker/ at large N.  The samples
+// are drawn in parallel, and their histogram is checked by the
+// chi-square test and the G-test (see goodness_of_fit.hpp).
+
+#include <cstdint>
+#include <random>
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+#include "walker/masked_sampling.hpp"
+#include "walker/multinomial_sampling.hpp"
+#include "walker/philox.hpp"
+#include "walker/random_choice.hpp"
+#include "walker/random_choice_bank.hpp"
+#include "walker/subset_sampling.hpp"
+#include "walker/sum_tree_sampling.hpp"
+#include "walker/tower_sampling.hpp"
+#include "walker/xoshiro.hpp"
+#include "goodness_of_fit.hpp"
+
+using walker::test::histogram;
+using walker::test::single_draws;
+
+static const std::size_t n = 100003;          // not a power of two
+static const std::uint64_t samples = 20000000; // 200 per bin on average
+static const double z_max = 5;
+
+// skewed weights with a zero weight in every 101 bins
+static std::vector<double> make_weights(std::size_t n) {
+  std::mt19937_64 eng(n);
+  std::uniform_real_distribution<> dist;
+  std::vector<double> weights(n);
+  for (std::size_t i = 0; i < n; ++i) {
+    double u = dist(eng);
+    weights[i] = (i % 101 == 50) ? 0 : u * u * u;
+  }
+  return weights;
+}
+
+static auto mt32 = [](unsigned int t) { return std::mt19937(29411 + t); };
+static auto mt64 = [](unsigned int t) { return std::mt19937_64(29411 + t); };
+static auto real = [](unsigned int t) {
+  return walker::test::make_uniform_01(std::mt19937_64(29411 + t)); };
+
+template<class CONT>
+void check_fit(CONT const& weights, std::vector<std::uint64_t> const& counts) {
+  auto r = walker::test::goodness_of_fit(weights, counts);
+  INFO("dof = " << r.dof << ", chi2 = " << r.chi2 << " (z = " << r.z_chi2 << "), G = " << r.g
+       << " (z = " << r.z_g << "), samples in zero-weight bins = " << r.zero_hits);
+  CHECK(r.zero_hits == 0);
+  CHECK(r.z_chi2 < z_max);
+  CHECK(r.z_g < z_max);
+}
+
+template<class Sampler, class MakeEngine>
+void check_sampler(Sampler const& sampler, std::vector<double> const& weights,
+                   MakeEngine const& make_engine, std::uint64_t m = samples) {
+  check_fit(weights, histogram(weights.size(), m, make_engine, single_draws(sampler)));
+}
+
+TEST_CASE("harness detects biased samples", "[statistics]") {
+  auto weights = make_weights(n);
+  walker::random_choice<std::mt19937> rc(weights);
+  // the next bin is taken instead with probability 1/64
+  auto draw = [&rc](std::mt19937& eng, std::uint64_t m, std::vector<std::uint64_t>& counts) {
+    for (std::uint64_t t = 0; t < m; ++t) {
+      auto x = rc(eng);
+      ++counts[((eng() & 63) == 0) ? (x + 1) % n : x];
+    }
+  };
+  auto r = walker::test::goodness_of_fit(weights, histogram(n, samples, mt32, draw));
+  CHECK(!r.passed(z_max));
+  weights[n - 1] = 0;
+  r = walker::test::goodness_of_fit(weights, histogram(n, samples, mt32, single_draws(rc)));
+  CHECK(r.zero_hits > 0);
+}
+
+TEST_CASE("random_choice", "[statistics]") {
+  auto weights = make_weights(n);
+  SECTION("32-bit engine") { check_sampler(walker::random_choice<std::mt19937>(weights), weights, mt32); }
+  SECTION("64-bit engine") { check_sampler(walker::random_choice<std::mt19937_64>(weights), weights, mt64); }
+  SECTION("real engine") { check_sampler(walker::random_choice<double>(weights), weights, real); }
+  SECTION("parallel construction") {
+    check_sampler(walker::random_choice<std::mt19937>(weights, 4), weights, mt32);
+  }
+  SECTION("single draw") {
+    walker::random_choice<std::mt19937_64> rc(weights);
+    auto draw = [&rc](std::mt19937_64& eng, std::uint64_t m, std::vector<std::uint64_t>& counts) {
+      for (std::uint64_t t = 0; t < m; ++t) ++counts[rc.single_draw(eng)];
+    };
+    check_fit(weights, histogram(n, samples, mt64, draw));
+  }
+  SECTION("philox4x32 streams") {
+    check_sampler(walker::random_choice<walker::philox4x32>(weights), weights,
+                  [](unsigned int t) { return walker::philox4x32(29411, t); });
+  }
+  SECTION("SIMD xoshiro256++") {
+    check_sampler(walker::random_choice<walker::xoshiro256pp_simd>(weights), weights,
+                  [](unsigned int t) { return walker::xoshiro256pp_simd(29411 + t); });
+  }
+}
+
+TEST_CASE("random_choice_compact", "[statistics]") {
+  auto weights = make_weights(n);
+  SECTION("float") {
+    check_sampler(walker::random_choice_compact<walker::width_f32>(weights), weights, real);
+  }
+  SECTION("64-bit") {
+    check_sampler(walker::random_choice_compact<walker::width_u64>(weights), weights, mt64);
+  }
+  SECTION("16-bit") {
+    auto small = make_weights(50000);
+    check_sampler(walker::random_choice_compact<walker::width_u16>(small), small, mt32);
+  }
+}
+
+TEST_CASE("alias table variants", "[statistics]") {
+  auto weights = make_weights(n);
+  SECTION("packed") { check_sampler(walker::detail::random_choice_packed<>(weights), weights, real); }
+  SECTION("multiply") { check_sampler(walker::detail::random_choice_multiply<>(weights), weights, mt32); }
+  SECTION("blocked") { check_sampler(walker::detail::random_choice_blocked<>(weights), weights, mt32); }
+  SECTION("bank") {
+    std::vector<std::vector<double> > weights_list = { make_weights(17), weights, make_weights(1000) };
+    walker::random_choice_bank<> bank(weights_list, 2);
+    for (std::size_t k = 0; k < bank.size(); ++k) {
+      auto draw = [&bank, k](std::mt19937& eng, std::uint64_t m, std::vector<std::uint64_t>& counts) {
+        for (std::uint64_t t = 0; t < m; ++t) ++counts[bank(k, eng)];
+      };
+      check_fit(weights_list[k], histogram(weights_list[k].size(), samples, mt32, draw));
+    }
+  }
+}
+
+TEST_CASE("search-based samplers", "[statistics]") {
+  auto weights = make_weights(n);
+  SECTION("bsearch") { check_sampler(walker::detail::random_choice_bsearch<>(weights), weights, real); }
+  SECTION("eytzinger") { check_sampler(walker::detail::random_choice_eytzinger<>(weights), weights, real); }
+  SECTION("guide") { check_sampler(walker::detail::random_choice_guide<>(weights), weights, real); }
+  SECTION("lsearch") {
+    // O(N) per sample
+    auto small = make_weights(1000);
+    check_sampler(walker::detail::random_choice_lsearch<>(small), small, real, 1000000);
+  }
+  SECTION("tower") {
+    check_sampler(walker::tower_sampling<>(weights.begin(), weights.end()), weights, mt64);
+  }
+  SECTION("sum tree") {
+    check_sampler(walker::sum_tree_sampling<>(weights.begin(), weights.end()), weights, mt64);
+  }
+}
+
+TEST_CASE("multinomial_sampling", "[statistics]") {
+  auto weights = make_weights(n);
+  walker::multinomial_sampling<> ms(weights.begin(), weights.end());
+  auto draw = [&ms](bool split) {
+    return [&ms, split](std::mt19937_64& eng, std::uint64_t m, std::vector<std::uint64_t>& counts) {
+      std::vector<std::uint64_t> c;
+      // draws in chunks, so that both algorithms are exercised
+      const std::uint64_t chunk = split ? 100 * n : n;
+      for (std::uint64_t done = 0; done < m; done += chunk) {
+        std::uint64_t k = std::min(chunk, m - done);
+        if (split)
+          ms.counts_split(eng, k, c);
+        else
+          ms.counts_alias(eng, k, c);
+        for (std::size_t i = 0; i < n; ++i) counts[i] += c[i];
+      }
+    };
+  };
+  SECTION("alias") { check_fit(weights, histogram(n, samples, mt64, draw(false))); }
+  SECTION("split") { check_fit(weights, histogram(n, samples, mt64, draw(true))); }
+}
+
+TEST_CASE("masked_sampling", "[statistics]") {
+  auto weights = make_weights(n);
+  walker::random_choice<std::mt19937> rc(weights);
+  std::vector<double> masked = weights;
+  // mask the first 30% (rejection) or 90% (tree) of the bins
+  for (double fraction : { 0.3, 0.9 }) {
+    walker::masked_sampling<walker::random_choice<std::mt19937> > ms(rc, weights);
+    for (std::size_t i = 0; i < fraction * n; ++i) {
+      ms.forbid(i);
+      masked[i] = 0;
+    }
+    check_sampler(ms, masked, mt32);
+  }
+}
+
+TEST_CASE("subset_sampling", "[statistics]") {
+  // the first element of a subset follows the weights
+  auto weights = make_weights(n);
+  walker::subset_sampling<> ss(weights.begin(), weights.end());
+  auto draw = [&ss](std::mt19937_64& eng, std::uint64_t m, std::vector<std::uint64_t>& counts) {
+    int x;
+    for (std::uint64_t t = 0; t < m; ++t) {
+      ss(eng, 1, &x);
+      ++counts[x];
+    }
+  };
+  check_fit(weights, histogram(n, samples / 10, mt64, draw));
+}
@@ -0,0 +1,162 @@
+/*
+   Copyright (C) 2022 by Synge Todo <wistaria@phys.s.u-tokyo.ac.jp>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <new>
+
+#if defined(__linux__)
+# define WALKER_HAVE_MADVISE 1
+# include <sys/mman.h>
+#endif
+
+namespace walker {
+
+namespace detail {
+
+// Memory aligned to `alignment' (a power of two).  The pointer returned
+// by operator new is stored just before the aligned block.
+inline void* aligned_malloc(std::size_t bytes, std::size_t alignment) {
+  if (alignment < sizeof(void*)) alignment = sizeof(void*);
+  void* p = ::operator new(bytes + alignment + sizeof(void*));
+  std::uintptr_t a = (reinterpret_cast<std::uintptr_t>(p) + sizeof(void*) + alignment - 1) &
+    ~std::uintptr_t(alignment - 1);
+  reinterpret_cast<void**>(a)[-1] = p;
+  return reinterpret_cast<void*>(a);
+}
+
+inline void aligned_free(void* p) noexcept {
+  if (p) ::operator delete(reinterpret_cast<void**>(p)[-1]);
+}
+
+static const std::size_t cache_line_size = 64;
+static const std::size_t huge_page_size = std::size_t(1) << 21; // 2 MB
+
+// Anonymous mapping of whole 2 MB pages aligned to 2 MB, for which
+// transparent huge pages are requested by madvise(MADV_HUGEPAGE).  The
+// request is a hint: the kernel may still use 4 KB pages, e.g. if
+// transparent huge pages are disabled ("never" in
+// /sys/kernel/mm/transparent_hugepage/enabled) or memory is fragmented.
+// Elsewhere, the memory is only aligned to 2 MB.
+inline std::size_t huge_page_bytes(std::size_t bytes) {
+  return (bytes + huge_page_size - 1) & ~(huge_page_size - 1);
+}
+
+inline void* huge_page_malloc(std::size_t bytes) {
+#ifdef WALKER_HAVE_MADVISE
+  std::size_t size = huge_page_bytes(bytes);
+  void* p = mmap(nullptr, size + huge_page_size, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (p == MAP_FAILED) throw std::bad_alloc();
+  // trim the mapping to the aligned block
+  char* first = static_cast<char*>(p);
+  char* a = reinterpret_cast<char*>((reinterpret_cast<std::uintptr_t>(p) + huge_page_size - 1) &
+                                    ~std::uintptr_t(huge_page_size - 1));
+  if (a > first) munmap(first, std::size_t(a - first));
+  std::size_t tail = std::size_t(first + size + huge_page_size - (a + size));
+  if (tail > 0) munmap(a + size, tail);
+# ifdef MADV_HUGEPAGE
+  madvise(a, size, MADV_HUGEPAGE);
+# endif
+  return a;
+#else
+  return aligned_malloc(bytes, huge_page_size);
+#endif
+}
+
+inline void huge_page_free(void* p, std::size_t bytes) noexcept {
+#ifdef WALKER_HAVE_MADVISE
+  if (p) munmap(p, huge_page_bytes(bytes));
+#else
+  (void)bytes;
+  aligned_free(p);
+#endif
+}
+
+template<class T>
+inline std::size_t allocation_bytes(std::size_t n) {
+  if (n > std::numeric_limits<std::size_t>::max() / sizeof(T)) throw std::bad_alloc();
+  return n * sizeof(T);
+}
+
+} // end namespace detail
+
+//
+// Allocators for the tables of the samplers (see the Allocator parameter
+// of random_choice, random_choice_walker, random_choice_bsearch and
+// tower_sampling).  Both are stateless, and thus any two instances
+// compare equal.
+//
+
+// Memory aligned to `Alignment' bytes (default: one cache line), so that
+// no table entry straddles two cache lines.
+template<class T, std::size_t Alignment = detail::cache_line_size>
+class aligned_allocator {
+public:
+  typedef T value_type;
+  template<class U> struct rebind { typedef aligned_allocator<U, Alignment> other; };
+
+  aligned_allocator() noexcept {}
+  template<class U>
+  aligned_allocator(aligned_allocator<U, Alignment> const&) noexcept {}
+
+  T* allocate(std::size_t n) {
+    return static_cast<T*>(detail::aligned_malloc(detail::allocation_bytes<T>(n), Alignment));
+  }
+  void deallocate(T* p, std::size_t) noexcept { detail::aligned_free(p); }
+};
+
+template<class T, class U, std::size_t A>
+bool operator==(aligned_allocator<T, A> const&, aligned_allocator<U, A> const&) { return true; }
+template<class T, class U, std::size_t A>
+bool operator!=(aligned_allocator<T, A> const&, aligned_allocator<U, A> const&) { return false; }
+
+// Tables of at least 2 MB are placed on transparent huge pages (see
+// detail::huge_page_malloc), so that a random access to a table of 1 GB
+// needs one of 512 TLB entries instead of one of 262144.  Smaller ones
+// are aligned to a cache line.
+template<class T>
+class huge_page_allocator {
+public:
+  typedef T value_type;
+
+  huge_page_allocator() noexcept {}
+  template<class U>
+  huge_page_allocator(huge_page_allocator<U> const&) noexcept {}
+
+  T* allocate(std::size_t n) {
+    std::size_t bytes = detail::allocation_bytes<T>(n);
+    return static_cast<T*>(bytes >= detail::huge_page_size ? detail::huge_page_malloc(bytes) :
+                           detail::aligned_malloc(bytes, detail::cache_line_size));
+  }
+  void deallocate(T* p, std::size_t n) noexcept {
+    std::size_t bytes = n * sizeof(T);
+    if (bytes >= detail::huge_page_size)
+      detail::huge_page_free(p, bytes);
+    else
+      detail::aligned_free(p);
+  }
+};
+
+template<class T, class U>
+bool operator==(huge_page_allocator<T> const&, huge_page_allocator<U> const&) { return true; }
+template<class T, class U>
+bool operator!=(huge_page_allocator<T> const&, huge_page_allocator<U> const&) { return false; }
+
+} // end namespace walker
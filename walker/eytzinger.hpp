@@ -0,0 +1,107 @@
+/*
+   Copyright (C) 2022 by Synge Todo <wistaria@phys.s.u-tokyo.ac.jp>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#if defined(__GNUC__) || defined(__clang__)
+# define WALKER_PREFETCH(addr) __builtin_prefetch(addr)
+#else
+# define WALKER_PREFETCH(addr) ((void)0)
+#endif
+
+namespace walker {
+
+namespace detail {
+
+// Sorted array stored in Eytzinger (breadth-first) order: node k has its
+// children at 2k and 2k+1, and the root is at 1.  The search for the
+// upper bound descends without branches on the data, and the nodes four
+// levels below (16 consecutive nodes, two cache lines) are prefetched.
+
+// Index of the node where the search ended after the last left turn
+inline std::size_t eytzinger_cancel_right_turns(std::size_t k) {
+#if defined(__GNUC__) || defined(__clang__)
+  return k >> __builtin_ffsll(~static_cast<unsigned long long>(k));
+#else
+  while (k & 1) k >>= 1;
+  return k >> 1;
+#endif
+}
+
+// The arrays are allocated by `Allocator' rebound to their elements.
+template<class ValueType, class IndexType = unsigned int,
+  class Allocator = std::allocator<ValueType> >
+class eytzinger_array {
+public:
+  typedef ValueType value_type;
+  typedef IndexType index_type;
+
+  eytzinger_array() : tree_(1), index_(1, 0) {}
+  template<class InputIterator>
+  eytzinger_array(InputIterator first, InputIterator last) { init(first, last); }
+
+  // `first'...`last' must be sorted in non-decreasing order
+  template<class InputIterator>
+  void init(InputIterator first, InputIterator last) {
+    std::vector<ValueType> sorted(first, last);
+    tree_.assign(sorted.size() + 1, ValueType(0));
+    index_.assign(sorted.size() + 1, 0);
+    std::size_t i = 0;
+    build(sorted, 1, i);
+    // the search ends at node 0 if `p' is not less than any element
+    index_[0] = sorted.size() ? IndexType(sorted.size() - 1) : 0;
+  }
+
+  std::size_t size() const { return tree_.size() - 1; }
+
+  // Position of the first element greater than `p', or the last position
+  // if there is no such element
+  IndexType upper_bound(ValueType p) const {
+    const ValueType* tree = tree_.data();
+    const std::size_t n = tree_.size();
+    std::size_t k = 1;
+    while (k < n) {
+      WALKER_PREFETCH(tree + 16 * k);
+      WALKER_PREFETCH(tree + 16 * k + 8);
+      k = 2 * k + (tree[k] <= p);
+    }
+    return index_[eytzinger_cancel_right_turns(k)];
+  }
+
+private:
+  void build(std::vector<ValueType> const& sorted, std::size_t k, std::size_t& i) {
+    if (k < tree_.size()) {
+      build(sorted, 2 * k, i);
+      tree_[k] = sorted[i];
+      index_[k] = IndexType(i);
+      ++i;
+      build(sorted, 2 * k + 1, i);
+    }
+  }
+
+  template<class T>
+  using vector = std::vector<T, typename std::allocator_traits<Allocator>::template rebind_alloc<T> >;
+  vector<ValueType> tree_;  // tree_[0] is not used
+  vector<IndexType> index_; // position of each node in the sorted array
+};
+
+} // end namespace detail
+
+} // end namespace walker
@@ -0,0 +1,191 @@
+/*
+   Copyright (C) 2022 by Synge Todo <wistaria@phys.s.u-tokyo.ac.jp>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+namespace walker {
+
+// Sampling from the distribution of an existing sampler (e.g. an alias
+// table), excluding the bins masked by forbid() until they are allowed
+// again by allow(), without rebuilding the table.
+//
+//  While the masked bins carry at most a fraction `threshold' of the
+//  total weight, a draw of the sampler is repeated until an allowed bin
+//  is obtained, i.e. 1 / (1 - masked_mass()) draws on average.
+//  Otherwise, a binary tree of partial sums of the allowed weights (see
+//  sum_tree_sampling) is used, which takes O(log N) time per draw.  The
+//  default threshold 0.8 is near the crossover measured by the masked_*
+//  cases of benchmark/walker for N = 10^3 to 10^5.
+//
+// The tree is built in O(N) time when the masked mass exceeds
+// `threshold', and is updated in O(log N) time by forbid() and allow()
+// while it is in use.  It is released from use only when the masked mass
+// drops below threshold / 2, so that masking and unmasking a single bin
+// near the threshold does not rebuild it repeatedly.  Otherwise forbid()
+// and allow() take O(1) time.  The sampler is not copied, and must
+// outlive this object.  operator() is const and may be called
+// concurrently, but not concurrently with forbid() or allow().  A
+// threshold of 0 (1) always (never) uses the tree.  Sampling throws
+// std::range_error if all the bins of positive weight are masked.
+
+template<class Sampler, class IntType = unsigned int>
+class masked_sampling {
+public:
+  typedef IntType result_type;
+
+  template<class CONT>
+  masked_sampling(Sampler const& sampler, CONT const& weights, double threshold = 0.8)
+    : sampler_(&sampler), threshold_(threshold) {
+    if (weights.size() == 0)
+      throw std::invalid_argument("masked_sampling");
+    size_ = weights.size();
+    leaves_ = 1;
+    while (leaves_ < size_) leaves_ <<= 1;
+    weights_.resize(size_);
+    total_ = 0;
+    positives_ = 0;
+    for (std::size_t i = 0; i < size_; ++i) {
+      if (weights[i] < 0)
+        throw std::invalid_argument("masked_sampling");
+      weights_[i] = weights[i];
+      total_ += weights_[i];
+      if (weights_[i] > 0) ++positives_;
+    }
+    if (total_ <= 0)
+      throw std::invalid_argument("masked_sampling");
+    mask_.assign((size_ + 63) / 64, 0);
+    masked_ = 0;
+    count_ = 0;
+    masked_positives_ = 0;
+    use_tree_ = false;
+    if (threshold_ <= 0) build_tree();
+  }
+
+  std::size_t size() const { return size_; }
+  bool forbidden(result_type i) const { return (mask_[i / 64] >> (i % 64)) & 1; }
+  // number of masked bins
+  std::size_t count() const { return count_; }
+  // fraction of the total weight carried by the masked bins
+  double masked_mass() const { return masked_ / total_; }
+  // whether draws are currently taken from the tree of partial sums
+  bool uses_tree() const { return use_tree_; }
+
+  void forbid(result_type i) {
+    if (forbidden(i)) return;
+    mask_[i / 64] |= std::uint64_t(1) << (i % 64);
+    masked_ += weights_[i];
+    ++count_;
+    if (weights_[i] > 0) ++masked_positives_;
+    if (use_tree_)
+      set_leaf(i, 0);
+    else if (masked_ > threshold_ * total_)
+      build_tree();
+  }
+
+  void allow(result_type i) {
+    if (!forbidden(i)) return;
+    mask_[i / 64] &= ~(std::uint64_t(1) << (i % 64));
+    // reset exactly, so that rounding errors do not accumulate
+    masked_ = (--count_ == 0) ? 0 : masked_ - weights_[i];
+    if (weights_[i] > 0) --masked_positives_;
+    if (use_tree_) {
+      if (masked_ < 0.5 * threshold_ * total_)
+        use_tree_ = false;
+      else
+        set_leaf(i, weights_[i]);
+    }
+  }
+
+  template<class InputIterator>
+  void forbid(InputIterator first, InputIterator last) {
+    for (; first != last; ++first) forbid(result_type(*first));
+  }
+  template<class InputIterator>
+  void allow(InputIterator first, InputIterator last) {
+    for (; first != last; ++first) allow(result_type(*first));
+  }
+
+  // allow all the bins in O(N / 64) time
+  void clear() {
+    std::fill(mask_.begin(), mask_.end(), 0);
+    masked_ = 0;
+    count_ = 0;
+    masked_positives_ = 0;
+    use_tree_ = (threshold_ <= 0);
+    if (use_tree_) build_tree();
+  }
+
+  template<class Engine>
+  result_type operator()(Engine& eng) const {
+    if (masked_positives_ == positives_)
+      throw std::range_error("masked_sampling: all the weight is masked");
+    if (!use_tree_) {
+      while (true) {
+        result_type i = result_type((*sampler_)(eng));
+        if (!forbidden(i)) return i;
+      }
+    }
+    std::uniform_real_distribution<> dist;
+    double u = tree_[1] * dist(eng);
+    std::size_t k = 1;
+    while (k < leaves_) {
+      k <<= 1;
+      // descend to the right if u exceeds the left subtree, unless the
+      // right subtree is empty (possible only by rounding errors)
+      if (u >= tree_[k] && tree_[k + 1] > 0) {
+        u -= tree_[k];
+        ++k;
+      }
+    }
+    return result_type(k - leaves_);
+  }
+
+private:
+  void build_tree() {
+    tree_.assign(2 * leaves_, 0.0);
+    for (std::size_t i = 0; i < size_; ++i)
+      tree_[leaves_ + i] = forbidden(result_type(i)) ? 0 : weights_[i];
+    for (std::size_t k = leaves_ - 1; k > 0; --k) tree_[k] = tree_[2 * k] + tree_[2 * k + 1];
+    use_tree_ = true;
+  }
+  void set_leaf(result_type i, double w) {
+    std::size_t k = leaves_ + i;
+    tree_[k] = w;
+    for (k >>= 1; k > 0; k >>= 1) tree_[k] = tree_[2 * k] + tree_[2 * k + 1];
+  }
+
+  Sampler const* sampler_;
+  double threshold_;
+  std::size_t size_;                // number of bins
+  std::size_t leaves_;              // number of leaves of the tree (power of two)
+  std::vector<double> weights_;
+  double total_;                    // sum of the weights
+  std::size_t positives_;           // number of bins with positive weight
+  std::vector<std::uint64_t> mask_; // bit i: whether bin i is masked
+  double masked_;                   // sum of the masked weights
+  std::size_t count_;               // number of masked bins
+  std::size_t masked_positives_;    // number of masked bins with positive weight
+  bool use_tree_;
+  std::vector<double> tree_;        // partial sums of the allowed weights (valid while use_tree_)
+};
+
+}
@@ -0,0 +1,116 @@
+/*
+   Copyright (C) 2022 by Synge Todo <wistaria@phys.s.u-tokyo.ac.jp>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <vector>
+#include "walker/random_choice.hpp"
+
+namespace walker {
+
+// Bin counts of M independent draws (multinomial distribution) without
+// drawing M samples one by one.  Two algorithms are provided:
+//
+//  counts_alias: M draws from an alias table.  O(M).
+//  counts_split: conditional binomial splitting, i.e. the count of i-th
+//    bin is drawn from Binomial(M - c_0 - ... - c_{i-1}, p_i / (p_i + ... +
+//    p_{N-1})).  O(N) binomial draws, independent of M.
+//
+// operator() selects one of them according to M/N.
+
+template<class IntType = int>
+class multinomial_sampling {
+public:
+  typedef IntType result_type;
+  typedef std::uint64_t count_type;
+  // counts_split is used if M >= split_ratio * N
+  static constexpr double split_ratio = 8;
+
+  multinomial_sampling() { const double one = 1.0; init(&one, &one + 1); }
+  template <class InputIterator>
+  multinomial_sampling(InputIterator firstW, InputIterator lastW) { init(firstW, lastW); }
+
+  template <class InputIterator>
+  void init(InputIterator firstW, InputIterator lastW) {
+    std::vector<double> weights(firstW, lastW);
+    if (weights.size() == 0)
+      throw std::invalid_argument("multinomial_sampling::init");
+    // conditional probabilities from the suffix sums, which are
+    // accumulated from the end to avoid cancellation
+    cond_.assign(weights.size(), 0);
+    double tail = 0;
+    bool positive = false;
+    for (std::size_t i = weights.size(); i-- > 0;) {
+      if (weights[i] < 0)
+        throw std::invalid_argument("multinomial_sampling::init");
+      if (weights[i] > 0 && !positive) {
+        // the last bin with positive weight takes all the remaining draws
+        positive = true;
+        tail = weights[i];
+        cond_[i] = 1;
+        continue;
+      }
+      tail += weights[i];
+      cond_[i] = (tail > 0) ? std::min(weights[i] / tail, 1.0) : 0;
+    }
+    if (!positive)
+      throw std::invalid_argument("multinomial_sampling::init");
+    alias_ = alias_type(weights);
+  }
+
+  std::size_t size() const { return cond_.size(); }
+
+  // counts[i] for m draws (`counts' is resized to the number of bins)
+  template<class Engine, class CONT>
+  void operator()(Engine& eng, count_type m, CONT& counts) const {
+    if (m >= split_ratio * size())
+      counts_split(eng, m, counts);
+    else
+      counts_alias(eng, m, counts);
+  }
+
+  template<class Engine, class CONT>
+  void counts_alias(Engine& eng, count_type m, CONT& counts) const {
+    counts.assign(size(), 0);
+    std::uniform_real_distribution<> dist;
+    auto u01 = [&]() { return dist(eng); };
+    for (count_type t = 0; t < m; ++t) ++counts[alias_(u01)];
+  }
+
+  template<class Engine, class CONT>
+  void counts_split(Engine& eng, count_type m, CONT& counts) const {
+    counts.assign(size(), 0);
+    typedef std::binomial_distribution<long long> binomial_type;
+    for (std::size_t i = 0; i < size() && m > 0; ++i) {
+      if (cond_[i] <= 0) continue;
+      count_type c = (cond_[i] < 1) ?
+        count_type(binomial_type((long long)(m), cond_[i])(eng)) : m;
+      counts[i] = c;
+      m -= c;
+    }
+  }
+
+private:
+  typedef detail::random_choice_walker<double, std::uint32_t, double> alias_type;
+  std::vector<double> cond_; // p_i / (p_i + ... + p_{N-1})
+  alias_type alias_;
+};
+
+}
@@ -0,0 +1,211 @@
+/*
+   Copyright (C) 2022 by Synge Todo <wistaria@phys.s.u-tokyo.ac.jp>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include "walker/simd.hpp"
+
+namespace walker {
+
+namespace detail {
+
+// Philox4x32-10 bijection of J. K. Salmon, M. A. Moraes, R. O. Dror, and
+// D. E. Shaw, Proc. SC11 (2011): a 128-bit counter `c' is encrypted in
+// place under a 64-bit key (k0, k1) by ten rounds of multiply-xor.
+constexpr std::uint32_t philox_m0 = 0xd2511f53u;
+constexpr std::uint32_t philox_m1 = 0xcd9e8d57u;
+constexpr std::uint32_t philox_w0 = 0x9e3779b9u;
+constexpr std::uint32_t philox_w1 = 0xbb67ae85u;
+
+inline void philox4x32_10(std::uint32_t* c, std::uint32_t k0, std::uint32_t k1) {
+  for (int r = 0; r < 10; ++r) {
+    std::uint64_t p0 = std::uint64_t(philox_m0) * c[0];
+    std::uint64_t p1 = std::uint64_t(philox_m1) * c[2];
+    std::uint32_t x0 = std::uint32_t(p1 >> 32) ^ c[1] ^ k0;
+    std::uint32_t x2 = std::uint32_t(p0 >> 32) ^ c[3] ^ k1;
+    c[0] = x0;
+    c[1] = std::uint32_t(p1);
+    c[2] = x2;
+    c[3] = std::uint32_t(p0);
+    k0 += philox_w0;
+    k1 += philox_w1;
+  }
+}
+
+// Write the blocks of counters (block, stream), ..., (block + n - 1,
+// stream) to out[0], ..., out[4 n - 1], where the lower and upper halves
+// of the 64-bit block index and stream are the four counter words.
+inline void philox_blocks_scalar(std::uint32_t k0, std::uint32_t k1, std::uint64_t block,
+  std::uint64_t stream, std::uint32_t* out, std::size_t n) {
+  for (std::size_t i = 0; i < n; ++i, ++block, out += 4) {
+    out[0] = std::uint32_t(block);
+    out[1] = std::uint32_t(block >> 32);
+    out[2] = std::uint32_t(stream);
+    out[3] = std::uint32_t(stream >> 32);
+    philox4x32_10(out, k0, k1);
+  }
+}
+
+#ifdef WALKER_HAVE_X86_SIMD
+
+// upper and lower halves of the 32x32-bit products of the eight lanes of `a' and `m'
+__attribute__((target("avx2")))
+inline void philox_mulhilo_avx2(__m256i a, __m256i m, __m256i& hi, __m256i& lo) {
+  __m256i even = _mm256_mul_epu32(a, m);
+  __m256i odd = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), m);
+  lo = _mm256_blend_epi32(even, _mm256_slli_epi64(odd, 32), 0xaa);
+  hi = _mm256_blend_epi32(_mm256_srli_epi64(even, 32), odd, 0xaa);
+}
+
+// Eight blocks per iteration, one per lane.  The lower word of the block
+// index must not wrap around within an iteration.
+__attribute__((target("avx2")))
+inline void philox_blocks_avx2(std::uint32_t k0, std::uint32_t k1, std::uint64_t block,
+  std::uint64_t stream, std::uint32_t* out, std::size_t n) {
+  const __m256i m0 = _mm256_set1_epi32(int(philox_m0));
+  const __m256i m1 = _mm256_set1_epi32(int(philox_m1));
+  const __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+  alignas(32) std::uint32_t w[4][8];
+  std::size_t i = 0;
+  for (; i + 8 <= n && std::uint32_t(block) <= 0xffffffffu - 7; i += 8, block += 8, out += 32) {
+    __m256i c0 = _mm256_add_epi32(_mm256_set1_epi32(int(std::uint32_t(block))), lane);
+    __m256i c1 = _mm256_set1_epi32(int(std::uint32_t(block >> 32)));
+    __m256i c2 = _mm256_set1_epi32(int(std::uint32_t(stream)));
+    __m256i c3 = _mm256_set1_epi32(int(std::uint32_t(stream >> 32)));
+    std::uint32_t key0 = k0, key1 = k1;
+    for (int r = 0; r < 10; ++r) {
+      __m256i hi0, lo0, hi1, lo1;
+      philox_mulhilo_avx2(c0, m0, hi0, lo0);
+      philox_mulhilo_avx2(c2, m1, hi1, lo1);
+      c0 = _mm256_xor_si256(_mm256_xor_si256(hi1, c1), _mm256_set1_epi32(int(key0)));
+      c1 = lo1;
+      c2 = _mm256_xor_si256(_mm256_xor_si256(hi0, c3), _mm256_set1_epi32(int(key1)));
+      c3 = lo0;
+      key0 += philox_w0;
+      key1 += philox_w1;
+    }
+    _mm256_store_si256(reinterpret_cast<__m256i*>(w[0]), c0);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(w[1]), c1);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(w[2]), c2);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(w[3]), c3);
+    for (int j = 0; j < 8; ++j)
+      for (int k = 0; k < 4; ++k) out[4 * j + k] = w[k][j];
+  }
+  philox_blocks_scalar(k0, k1, block, stream, out, n - i);
+}
+
+#endif // WALKER_HAVE_X86_SIMD
+
+inline void philox_blocks(std::uint32_t k0, std::uint32_t k1, std::uint64_t block,
+  std::uint64_t stream, std::uint32_t* out, std::size_t n) {
+#ifdef WALKER_HAVE_X86_SIMD
+  if (simd_level().load(std::memory_order_relaxed) != simd_isa::scalar) {
+    philox_blocks_avx2(k0, k1, block, stream, out, n);
+    return;
+  }
+#endif
+  philox_blocks_scalar(k0, k1, block, stream, out, n);
+}
+
+} // end namespace detail
+
+//
+// philox4x32: counter-based engine returning 32-bit words
+//
+// The k-th block of four words of stream `s' is the Philox4x32-10
+// encryption of the counter (k, s) under the seed, so that it is computed
+// independently of the other blocks.  Thus discard() takes O(1) time, and
+// split(s) gives 2^64 statistically independent streams of 2^66 words for
+// one seed, e.g. one per thread, with 48 bytes of state each.  fill()
+// returns the same words as repeated calls of operator(), but generates
+// whole blocks with SIMD instructions if available (see simd_level).
+//
+
+class philox4x32 {
+public:
+  typedef std::uint32_t result_type;
+  static constexpr std::uint64_t default_seed = 29411;
+
+  explicit philox4x32(std::uint64_t s = default_seed, std::uint64_t stream = 0) {
+    seed(s, stream);
+  }
+  void seed(std::uint64_t s = default_seed, std::uint64_t stream = 0) {
+    key_ = s;
+    stream_ = stream;
+    block_ = 0;
+    pos_ = 4;
+  }
+
+  static constexpr result_type min() { return 0; }
+  static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+  result_type operator()() {
+    if (pos_ == 4) refill();
+    return buffer_[pos_++];
+  }
+
+  // Fill [first, last) with the next last - first words
+  void fill(result_type* first, result_type* last) {
+    for (; pos_ < 4 && first != last; ++first) *first = buffer_[pos_++];
+    std::size_t n = std::size_t(last - first) / 4;
+    detail::philox_blocks(std::uint32_t(key_), std::uint32_t(key_ >> 32), block_, stream_, first, n);
+    block_ += n;
+    for (first += 4 * n; first != last; ++first) *first = operator()();
+  }
+
+  // Skip `z' words in O(1) time
+  void discard(unsigned long long z) { seek(position() + z); }
+
+  // number of words consumed in the current stream (modulo 2^64)
+  std::uint64_t position() const { return 4 * block_ - (4 - pos_); }
+  // Move to the `w'-th word of the current stream
+  void seek(std::uint64_t w) {
+    block_ = w / 4;
+    pos_ = 4;
+    if (w % 4) {
+      refill();
+      pos_ = unsigned(w % 4);
+    }
+  }
+
+  // Engine with the same seed positioned at the beginning of `stream'
+  philox4x32 split(std::uint64_t stream) const { return philox4x32(key_, stream); }
+  std::uint64_t stream() const { return stream_; }
+
+  friend bool operator==(philox4x32 const& x, philox4x32 const& y) {
+    return x.key_ == y.key_ && x.stream_ == y.stream_ && x.position() == y.position();
+  }
+  friend bool operator!=(philox4x32 const& x, philox4x32 const& y) { return !(x == y); }
+
+private:
+  void refill() {
+    detail::philox_blocks_scalar(std::uint32_t(key_), std::uint32_t(key_ >> 32), block_, stream_,
+      buffer_, 1);
+    ++block_;
+    pos_ = 0;
+  }
+
+  std::uint64_t key_;
+  std::uint64_t stream_;
+  std::uint64_t block_;   // index of the next block to generate
+  unsigned int pos_;      // next word in buffer_ (4: empty)
+  result_type buffer_[4]; // words of block block_ - 1
+};
+
+} // end namespace walker
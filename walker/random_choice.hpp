@@ -16,65 +16,113 @@
 
 #pragma once
 
+#include <algorithm>
+#include <cassert>
 #include <cmath>
+#include <cstdint>
+#include <exception>
 #include <iostream>
 #include <limits>
+#include <memory>
 #include <numeric>
 #include <stdexcept>
+#include <string>
+#include <thread>
 #include <type_traits>
 #include <utility>
 #include <vector>
+#include "walker/allocator.hpp"
+#include "walker/eytzinger.hpp"
+#include "walker/simd.hpp"
+#include "walker/table_file.hpp"
+#include "walker/table_storage.hpp"
 
 namespace walker {
 
 namespace detail {
 
-template<typename WVEC, typename CutoffType, typename IndexType>
-inline bool check_table(WVEC const& weights,
-  std::vector<std::pair<CutoffType, IndexType> > const& table, double tol = 1.0e-10) {
+// Check that the probability of each bin, i.e. its own cutoff plus the
+// remainders of all the entries aliased to it, reproduces the normalized
+// weight within `tol' * N.  The probabilities are accumulated in one pass
+// over the table, and thus the check takes O(N + M) time and O(M) memory.
+// Bins beyond the weights (padding) must have vanishing probability.
+template<typename WVEC, typename TABLE>
+inline bool check_table(WVEC const& weights, TABLE const& table, double tol = 1.0e-10) {
+  typedef typename TABLE::value_type::first_type CutoffType;
   std::size_t n = weights.size();
   std::size_t m = table.size();
-  bool r = true;
   tol *= n;
   double norm = m / std::accumulate(weights.begin(), weights.end(), double(0));
   double nm = 1;
   if (std::is_integral<CutoffType>::value) nm /= std::numeric_limits<CutoffType>::max();
-  for (IndexType i = 0; i < n; ++i) {
-    double p = nm * table[i].first;
-    for (IndexType j = 0; j < m; ++j)
-      if (table[j].second == i) p += (1.0 - nm * table[j].first);
-    r &= std::abs(p - norm * weights[i]) < tol;
+  std::vector<double> p(std::max(n, m), 0.0);
+  for (std::size_t j = 0; j < m; ++j) {
+    double c = nm * table[j].first;
+    std::size_t a = std::size_t(table[j].second);
+    if (a >= p.size()) return false;
+    p[j] += c;
+    p[a] += 1.0 - c;
   }
+  bool r = true;
+  for (std::size_t i = 0; i < p.size(); ++i)
+    r &= std::abs(p[i] - (i < n ? norm * weights[i] : 0.0)) < tol;
   return r;
 }
 
-// Initialization routine with complexity O(N)
-template<typename WVEC, typename CutoffType, typename IndexType,
+// Cutoff value for probability `c'.  Integer cutoffs are fixed-point
+// fractions scaled by the maximum of CutoffType.  The maximum of a 64-bit
+// type is rounded up to 2^64 in double precision, and thus the product
+// is clamped before conversion.
+template<typename CutoffType,
+  std::enable_if_t<std::is_floating_point<CutoffType>::value, std::nullptr_t> = nullptr>
+constexpr CutoffType to_cutoff(double c) { return CutoffType(c); }
+
+template<typename CutoffType,
+  std::enable_if_t<std::is_integral<CutoffType>::value, std::nullptr_t> = nullptr>
+constexpr CutoffType to_cutoff(double c) {
+  const double nm = double(std::numeric_limits<CutoffType>::max());
+  double x = nm * std::min(std::max(c, 0.0), 1.0);
+  return (x < nm) ? CutoffType(x) : std::numeric_limits<CutoffType>::max();
+}
+
+// Work array of fill_ft2009: pairs of (normalized weight - 1, index)
+template<typename CutoffType, typename IndexType>
+using ft2009_array = std::vector<std::pair<typename std::conditional<
+  std::is_floating_point<CutoffType>::value,
+  typename std::common_type<CutoffType, double>::type, double>::type, IndexType> >;
+
+// Initialization routine with complexity O(N).  Calculation is done in
+// double precision (at least) also for narrower cutoff types.
+template<typename WVEC, typename CutoffType, typename IndexType, typename Allocator,
   std::enable_if_t<std::is_floating_point<CutoffType>::value, std::nullptr_t> = nullptr,
   std::enable_if_t<std::is_integral<IndexType>::value, std::nullptr_t> = nullptr>
-inline void fill_ft2009(WVEC const& weights, std::vector<std::pair<CutoffType, IndexType> >& table) {
+inline void fill_ft2009(WVEC const& weights, std::vector<std::pair<CutoffType, IndexType>, Allocator>& table,
+  ft2009_array<CutoffType, IndexType>& array) {
+  typedef typename std::common_type<CutoffType, double>::type real_type;
   if (weights.size() == 0)
     throw std::invalid_argument("fill_ft2009");
   std::size_t n = weights.size();
-  CutoffType norm = CutoffType(0);
+  if (n - 1 > std::size_t(std::numeric_limits<IndexType>::max()))
+    throw std::range_error("fill_ft2009");
+  real_type norm = real_type(0);
   for (auto w : weights) {
-    if (w < CutoffType(0))
+    if (w < real_type(0))
       throw std::invalid_argument("fill_ft2009");
     norm += w;
   }
-  if (norm <= CutoffType(0))
+  if (norm <= real_type(0))
     throw std::invalid_argument("fill_ft2009");
   norm = n / norm;
 
   // Initialize arrays.  We will reorder the elements in `array', so
   // that all the negative elements precede the positive ones.
   table.resize(n);
-  std::vector<std::pair<CutoffType, IndexType> > array(n);
-  typename std::vector<std::pair<CutoffType, IndexType> >::iterator neg_p = array.begin();
-  typename std::vector<std::pair<CutoffType, IndexType> >::iterator pos_p = array.end();
+  array.resize(n);
+  typename std::vector<std::pair<real_type, IndexType> >::iterator neg_p = array.begin();
+  typename std::vector<std::pair<real_type, IndexType> >::iterator pos_p = array.end();
   for (std::size_t i = 0; i < n; ++i) {
-    CutoffType b = norm * weights[i] - CutoffType(1);
-    if (b < CutoffType(0)) {
+    real_type b = norm * weights[i] - real_type(1);
+    if (b < real_type(0)) {
       *neg_p = std::make_pair(b, i);
       ++neg_p;
     } else {
@@ -88,24 +136,27 @@ inline void fill_ft2009(WVEC const& weights, std::vector<std::pair<CutoffType, I
   // Assign alias and cutoff values
   for (neg_p = array.begin(); neg_p != array.end(); ++neg_p) {
     if (pos_p != array.end()) {
-      table[neg_p->second] = std::make_pair(CutoffType(1) + neg_p->first, pos_p->second);
+      table[neg_p->second] = std::make_pair(CutoffType(real_type(1) + neg_p->first), pos_p->second);
       pos_p->first += neg_p->first;
-      if (pos_p->first <= CutoffType(0)) ++pos_p;
+      if (pos_p->first <= real_type(0)) ++pos_p;
     } else {
       table[neg_p->second] = std::make_pair(CutoffType(1), neg_p->second);
     }
   }
 }
   
-template<typename WVEC, typename CutoffType, typename IndexType,
+template<typename WVEC, typename CutoffType, typename IndexType, typename Allocator,
   std::enable_if_t<std::is_integral<CutoffType>::value, std::nullptr_t> = nullptr,
   std::enable_if_t<std::is_integral<IndexType>::value, std::nullptr_t> = nullptr>
-inline void fill_ft2009(WVEC const& weights, std::vector<std::pair<CutoffType, IndexType> >& table) {
+inline void fill_ft2009(WVEC const& weights, std::vector<std::pair<CutoffType, IndexType>, Allocator>& table,
+  ft2009_array<CutoffType, IndexType>& array) {
   if (weights.size() == 0)
     throw std::range_error("fill_ft2009");
   std::size_t n = weights.size();
   std::size_t m = 2;
   while (m < n) m <<= 1;
+  if (m - 1 > std::size_t(std::numeric_limits<IndexType>::max()))
+    throw std::range_error("fill_ft2009");
 
   double norm = 0;
   for (auto w : weights) {
@@ -120,7 +171,7 @@ inline void fill_ft2009(WVEC const& weights, std::vector<std::pair<CutoffType, I
   // Initialize arrays.  We will reorder the elements in `array', so
   // that all the negative elements precede the positive ones.
   table.resize(m);
-  std::vector<std::pair<double, IndexType> > array(m);
+  array.resize(m);
   typename std::vector<std::pair<double, IndexType> >::iterator neg_p = array.begin();
   typename std::vector<std::pair<double, IndexType> >::iterator pos_p = array.end();
   for (std::size_t i = 0; i < m; ++i) {
@@ -137,18 +188,180 @@ inline void fill_ft2009(WVEC const& weights, std::vector<std::pair<CutoffType, I
   // Note: now `pos_p' is pointing the first non-negative element in the array.
 
   // Assign alias and cutoff values
-  double nm = std::numeric_limits<CutoffType>::max();
   for (neg_p = array.begin(); neg_p != array.end(); ++neg_p) {
     if (pos_p != array.end()) {
-      table[neg_p->second] = std::make_pair(CutoffType(nm * (1 + neg_p->first)), pos_p->second);
+      table[neg_p->second] = std::make_pair(to_cutoff<CutoffType>(1 + neg_p->first), pos_p->second);
       pos_p->first += neg_p->first;
       if (pos_p->first <= 0) ++pos_p;
     } else {
-      table[neg_p->second] = std::make_pair(CutoffType(nm), neg_p->second);
+      table[neg_p->second] = std::make_pair(to_cutoff<CutoffType>(1), neg_p->second);
     }
   }
 }
 
+// The above with a temporary work array.  Rebuilding with the same
+// `table' and `array' allocates nothing once their capacities suffice.
+template<typename WVEC, typename CutoffType, typename IndexType, typename Allocator>
+inline void fill_ft2009(WVEC const& weights, std::vector<std::pair<CutoffType, IndexType>, Allocator>& table) {
+  ft2009_array<CutoffType, IndexType> array;
+  fill_ft2009(weights, table, array);
+}
+
+// Run f(0), ..., f(nthreads - 1) concurrently.  An exception thrown by
+// any of them is rethrown in the calling thread.
+template<typename FUNC>
+inline void parallel_run(unsigned int nthreads, FUNC const& f) {
+  std::vector<std::exception_ptr> excp(nthreads);
+  std::vector<std::thread> threads;
+  for (unsigned int t = 1; t < nthreads; ++t)
+    threads.emplace_back([&f, &excp, t]() {
+      try { f(t); } catch (...) { excp[t] = std::current_exception(); }
+    });
+  try { f(0); } catch (...) { excp[0] = std::current_exception(); }
+  for (auto& th : threads) th.join();
+  for (auto& e : excp) if (e) std::rethrow_exception(e);
+}
+
+inline unsigned int default_concurrency() {
+  unsigned int p = std::thread::hardware_concurrency();
+  return p > 0 ? p : 1;
+}
+
+// Parallel initialization routine with complexity O(N/P + P log N)
+// based on the split-pair construction given in M. Hübschle-Schneider and
+// P. Sanders, ACM Trans. Math. Software 48, 45 (2022).  Light (w < 1)
+// and heavy (w >= 1) elements are processed in the order of their
+// indices.  Since the cutoff value and the alias of each element are
+// determined solely by the prefix sums of the deficits (1 - w) of the
+// light elements and of the excesses (w - 1) of the heavy ones, the
+// table can be filled by independent threads, each starting from a
+// split point found by binary search.  The table has `m' entries,
+// elements beyond weights.size() have zero weight.
+template<typename WVEC, typename CutoffType, typename IndexType, typename Allocator>
+inline void fill_hs2019_impl(WVEC const& weights, std::size_t m,
+  std::vector<std::pair<CutoffType, IndexType>, Allocator>& table, unsigned int nthreads) {
+  std::size_t n = weights.size();
+  if (nthreads == 0) nthreads = default_concurrency();
+  nthreads = unsigned(std::min<std::size_t>(nthreads, std::max<std::size_t>(m / 1024, 1)));
+  auto chunk = [m, nthreads](std::size_t t) { return m * t / nthreads; };
+
+  // Normalization
+  std::vector<double> partial(nthreads, 0);
+  parallel_run(nthreads, [&](unsigned int t) {
+    double s = 0;
+    for (std::size_t i = chunk(t); i < std::min(chunk(t + 1), n); ++i) {
+      if (weights[i] < 0)
+        throw std::invalid_argument("fill_hs2019");
+      s += weights[i];
+    }
+    partial[t] = s;
+  });
+  double norm = 0;
+  for (auto s : partial) norm += s;
+  if (norm <= 0)
+    throw std::invalid_argument("fill_hs2019");
+  norm = m / norm;
+  auto weight = [&weights, n, norm](std::size_t i) { return i < n ? norm * weights[i] : 0.0; };
+
+  // Partition into light and heavy elements
+  std::vector<std::size_t> nlight(nthreads + 1, 0), nheavy(nthreads + 1, 0);
+  parallel_run(nthreads, [&](unsigned int t) {
+    std::size_t c = 0;
+    for (std::size_t i = chunk(t); i < chunk(t + 1); ++i) c += (weight(i) < 1);
+    nlight[t + 1] = c;
+    nheavy[t + 1] = chunk(t + 1) - chunk(t) - c;
+  });
+  for (unsigned int t = 0; t < nthreads; ++t) {
+    nlight[t + 1] += nlight[t];
+    nheavy[t + 1] += nheavy[t];
+  }
+  std::size_t nl = nlight[nthreads], nh = nheavy[nthreads];
+  std::vector<IndexType> light(nl), heavy(nh);
+  std::vector<double> deficit(nl + 1), excess(nh + 1); // exclusive prefix sums
+  std::vector<double> dsum(nthreads + 1, 0), esum(nthreads + 1, 0);
+  parallel_run(nthreads, [&](unsigned int t) {
+    std::size_t l = nlight[t], h = nheavy[t];
+    double d = 0, e = 0;
+    for (std::size_t i = chunk(t); i < chunk(t + 1); ++i) {
+      double w = weight(i);
+      if (w < 1) {
+        light[l] = i;
+        d += 1 - w;
+        deficit[++l] = d;
+      } else {
+        heavy[h] = i;
+        e += w - 1;
+        excess[++h] = e;
+      }
+    }
+    dsum[t + 1] = d;
+    esum[t + 1] = e;
+  });
+  for (unsigned int t = 0; t < nthreads; ++t) {
+    dsum[t + 1] += dsum[t];
+    esum[t + 1] += esum[t];
+  }
+  parallel_run(nthreads, [&](unsigned int t) {
+    for (std::size_t l = nlight[t] + 1; l <= nlight[t + 1]; ++l) deficit[l] += dsum[t];
+    for (std::size_t h = nheavy[t] + 1; h <= nheavy[t + 1]; ++h) excess[h] += esum[t];
+  });
+
+  // Assign alias and cutoff values.  The light element l is aliased to
+  // the current heavy element h, i.e. the one with excess[h] < deficit[l]
+  // <= excess[h + 1].  The heavy element h becomes light, and is aliased
+  // to h + 1, when the accumulated deficit exceeds excess[h + 1].
+  table.resize(m);
+  parallel_run(nthreads, [&](unsigned int t) {
+    std::size_t first = nl * t / nthreads, last = nl * (t + 1) / nthreads;
+    if (first == last || nh == 0) return;
+    std::size_t h = std::lower_bound(excess.begin() + 1, excess.begin() + nh, deficit[first]) -
+      (excess.begin() + 1);
+    for (std::size_t l = first; l < last; ++l) {
+      table[light[l]] = std::make_pair(to_cutoff<CutoffType>(weight(light[l])), heavy[h]);
+      while (h + 1 < nh && excess[h + 1] < deficit[l + 1]) {
+        table[heavy[h]] =
+          std::make_pair(to_cutoff<CutoffType>(1 + excess[h + 1] - deficit[l + 1]), heavy[h + 1]);
+        ++h;
+      }
+    }
+  });
+  // Heavy elements remaining at the end are not aliased.
+  parallel_run(nthreads, [&](unsigned int t) {
+    for (std::size_t h = nh * t / nthreads; h < nh * (t + 1) / nthreads; ++h)
+      if (h + 1 == nh || !(excess[h + 1] < deficit[nl]))
+        table[heavy[h]] = std::make_pair(to_cutoff<CutoffType>(1), heavy[h]);
+  });
+  // Without heavy elements, all the weights are equal up to rounding errors.
+  if (nh == 0)
+    for (std::size_t i = 0; i < m; ++i) table[i] = std::make_pair(to_cutoff<CutoffType>(1), i);
+}
+
+template<typename WVEC, typename CutoffType, typename IndexType, typename Allocator,
+  std::enable_if_t<std::is_floating_point<CutoffType>::value, std::nullptr_t> = nullptr,
+  std::enable_if_t<std::is_integral<IndexType>::value, std::nullptr_t> = nullptr>
+inline void fill_hs2019(WVEC const& weights, std::vector<std::pair<CutoffType, IndexType>, Allocator>& table,
+  unsigned int nthreads = 0) {
+  if (weights.size() == 0)
+    throw std::invalid_argument("fill_hs2019");
+  if (weights.size() - 1 > std::size_t(std::numeric_limits<IndexType>::max()))
+    throw std::range_error("fill_hs2019");
+  fill_hs2019_impl(weights, weights.size(), table, nthreads);
+}
+
+template<typename WVEC, typename CutoffType, typename IndexType, typename Allocator,
+  std::enable_if_t<std::is_integral<CutoffType>::value, std::nullptr_t> = nullptr,
+  std::enable_if_t<std::is_integral<IndexType>::value, std::nullptr_t> = nullptr>
+inline void fill_hs2019(WVEC const& weights, std::vector<std::pair<CutoffType, IndexType>, Allocator>& table,
+  unsigned int nthreads = 0) {
+  if (weights.size() == 0)
+    throw std::range_error("fill_hs2019");
+  std::size_t m = 2;
+  while (m < weights.size()) m <<= 1;
+  if (m - 1 > std::size_t(std::numeric_limits<IndexType>::max()))
+    throw std::range_error("fill_hs2019");
+  fill_hs2019_impl(weights, m, table, nthreads);
+}
+
 // Original O(N^2) initialization routine given in A. W. Walker, ACM
 // Trans. Math. Software, 3, 253 (1977).
 template<typename WVEC, typename CutoffType, typename IndexType,
@@ -203,23 +416,171 @@ inline void fill_walker1977(WVEC const& weights, std::vector<std::pair<CutoffTyp
   }
 }
 
-template<class CutoffType, class IntType, class RealType, class Enable = void>
+// Whether `Engine' returns uniform integers in [0, 2^64)
+template<class Engine>
+struct is_engine64 : std::integral_constant<bool, Engine::min() == 0 &&
+  Engine::max() == std::numeric_limits<std::uint64_t>::max()> {};
+
+// Whether `Engine' provides fill(first, last) returning the same words as
+// repeated calls of operator(), e.g. philox4x32
+template<class Engine, class = void>
+struct has_fill : std::false_type {};
+
+template<class Engine>
+struct has_fill<Engine, decltype(std::declval<Engine&>().fill(
+  std::declval<typename Engine::result_type*>(), std::declval<typename Engine::result_type*>()))>
+  : std::true_type {};
+
+// Next 2 k words of `eng' alternately to r1[0], r2[0], r1[1], ...
+template<class Engine>
+inline void draw_pairs(Engine& eng, std::uint32_t* r1, std::uint32_t* r2, std::size_t k,
+  std::false_type) {
+  for (std::size_t i = 0; i < k; ++i) {
+    r1[i] = eng();
+    r2[i] = eng();
+  }
+}
+
+template<class Engine>
+inline void draw_pairs(Engine& eng, std::uint32_t* r1, std::uint32_t* r2, std::size_t k,
+  std::true_type) {
+  typename Engine::result_type w[512];
+  for (std::size_t i = 0; i < k;) {
+    std::size_t l = std::min<std::size_t>(256, k - i);
+    eng.fill(w, w + 2 * l);
+    for (std::size_t j = 0; j < l; ++j, ++i) {
+      r1[i] = w[2 * j];
+      r2[i] = w[2 * j + 1];
+    }
+  }
+}
+
+template<class Engine>
+inline void draw_pairs(Engine& eng, std::uint32_t* r1, std::uint32_t* r2, std::size_t k) {
+  draw_pairs(eng, r1, r2, k, has_fill<Engine>());
+}
+
+constexpr int bit_width(std::uint64_t x) { return x ? 1 + bit_width(x >> 1) : 0; }
+
+// Number of random bits per call of `Engine', which must return uniform
+// integers in [0, 2^bits), e.g. 32 for std::mt19937 (whose result_type may
+// be wider) and 64 for std::mt19937_64
+template<class Engine>
+struct engine_bits : std::integral_constant<int, bit_width(Engine::max())> {
+  static_assert(Engine::min() == 0 && (Engine::max() & (Engine::max() + 1)) == 0,
+    "engine must return uniform integers in [0, 2^bits)");
+};
+
+// Split a 64-bit random word `w' into a bin index in [0, n) (return
+// value) and a 64-bit fraction `frac' by taking the upper and lower
+// halves of the 128-bit product w * n.  Each bin receives either
+// floor(2^64 / n) or ceil(2^64 / n) words, and within a bin the fraction
+// is resolved in steps of n 2^-64.  `n' must be smaller than 2^32.
+inline std::uint64_t multiply_shift(std::uint64_t w, std::uint64_t n, std::uint64_t& frac) {
+#ifdef __SIZEOF_INT128__
+  unsigned __int128 p = static_cast<unsigned __int128>(w) * n;
+  frac = std::uint64_t(p);
+  return std::uint64_t(p >> 64);
+#else
+  std::uint64_t lo = (w & 0xffffffffu) * n;
+  std::uint64_t t = (w >> 32) * n + (lo >> 32);
+  frac = (t << 32) | (lo & 0xffffffffu);
+  return t >> 32;
+#endif
+}
+
+// Whether the `W'-bit random word `r' is smaller than the cutoff value
+// `c', both read as fixed-point fractions.  A word wider than the cutoff
+// is truncated, a narrower one fills the upper bits of the cutoff (the
+// resolution is then 2^-W).
+template<int W, class CutoffType>
+inline bool below_cutoff(std::uint64_t r, CutoffType c) {
+  constexpr int digits = std::numeric_limits<CutoffType>::digits;
+  constexpr int down = (W > digits) ? W - digits : 0;
+  constexpr int up = (W < digits) ? digits - W : 0;
+  return CutoffType(CutoffType(r >> down) << up) < c;
+}
+
+// Uniform integer in [0, n) by the nearly divisionless method of
+// D. Lemire, ACM Trans. Model. Comput. Simul. 29, 3 (2019): the upper
+// part of the product of a W-bit word and n is the result, and the
+// 2^W mod n smallest lower parts are rejected, so that the result is
+// exact.  The modulo is computed only when the lower part is below n,
+// i.e. with probability n 2^-W.  `Engine' must return words of at most
+// 32 bits with n <= 2^W, or of 64 bits with n < 2^32 (see multiply_shift).
+template<class Engine>
+inline std::uint64_t reduce_range(Engine& eng, std::uint64_t n, std::false_type) {
+  constexpr int w = engine_bits<Engine>::value;
+  const std::uint64_t mask = (std::uint64_t(1) << w) - 1;
+  std::uint64_t p = std::uint64_t(eng()) * n;
+  if ((p & mask) < n) {
+    std::uint64_t t = (mask + 1 - n) % n;
+    while ((p & mask) < t) p = std::uint64_t(eng()) * n;
+  }
+  return p >> w;
+}
+
+template<class Engine>
+inline std::uint64_t reduce_range(Engine& eng, std::uint64_t n, std::true_type) {
+  std::uint64_t frac;
+  std::uint64_t x = multiply_shift(eng(), n, frac);
+  if (frac < n) {
+    std::uint64_t t = (0 - n) % n;
+    while (frac < t) x = multiply_shift(eng(), n, frac);
+  }
+  return x;
+}
+
+template<class Engine>
+inline std::uint64_t reduce_range(Engine& eng, std::uint64_t n) {
+  constexpr int w = engine_bits<Engine>::value;
+  static_assert(w <= 32 || w == 64, "reduce_range requires a 64-bit engine or one of at most 32 bits");
+  return reduce_range(eng, n, std::integral_constant<bool, w == 64>());
+}
+
+// The table is allocated by `Allocator' rebound to the table entry,
+// e.g. huge_page_allocator (see allocator.hpp) for large tables.
+template<class CutoffType, class IntType, class RealType,
+  class Allocator = std::allocator<std::pair<CutoffType, IntType> >, class Enable = void>
 class random_choice_walker;
 
 //
 // double-based Walker algorithm
 //
 
-template<class CutoffType, class IntType, class RealType>
-class random_choice_walker<CutoffType, IntType, RealType,
+template<class CutoffType, class IntType, class RealType, class Allocator>
+class random_choice_walker<CutoffType, IntType, RealType, Allocator,
   typename std::enable_if<std::is_floating_point<CutoffType>::value>::type> {
 public:
   typedef RealType input_type;
   typedef IntType result_type;
+  typedef detail::ft2009_array<CutoffType, IntType> workspace_type;
 
   random_choice_walker() {}
   template<class CONT>
-  random_choice_walker(const CONT& weights) { detail::fill_ft2009(weights, table_); }
+  random_choice_walker(const CONT& weights) {
+    table_.fill([&](table_type& t) { detail::fill_ft2009(weights, t); });
+  }
+  // parallel construction with `nthreads' threads (0: all hardware threads)
+  template<class CONT>
+  random_choice_walker(const CONT& weights, unsigned int nthreads) {
+    table_.fill([&](table_type& t) { detail::fill_hs2019(weights, t, nthreads); });
+  }
+
+  // Rebuild the table for new `weights' in place.  The table and the
+  // work array, which is shared by the tables of the same type in each
+  // thread, keep their capacities, so that rebuilding with at most as
+  // many weights as before allocates no memory.
+  template<class CONT>
+  void rebuild(const CONT& weights) {
+    static thread_local workspace_type work;
+    rebuild(weights, work);
+  }
+  // the same with a work array owned by the caller, e.g. shared by many tables
+  template<class CONT>
+  void rebuild(const CONT& weights, workspace_type& work) {
+    table_.fill([&](table_type& t) { detail::fill_ft2009(weights, t, work); });
+  }
 
   template<class Engine>
   result_type operator()(Engine& eng) const {
@@ -227,19 +588,84 @@ public:
     return (eng() < cutoff(x)) ? x : alias(x);
   }
 
+  // Sampling with one call of a 64-bit engine (e.g. std::mt19937_64)
+  // instead of two calls of a real-valued one.  The bin and the value
+  // compared with the cutoff are taken from the upper and lower halves of
+  // the 128-bit product of the random word and N (see multiply_shift), so
+  // that the probability of each bin is biased by at most N 2^-64.
+  template<class Engine>
+  result_type single_draw(Engine& eng) const {
+    static_assert(detail::is_engine64<Engine>::value, "single_draw requires a 64-bit engine");
+    std::uint64_t frac;
+    result_type x = result_type(detail::multiply_shift(eng(), size(), frac));
+    return (RealType(frac) * two_m64 < cutoff(x)) ? x : alias(x);
+  }
+
+  // Fill [first, last) with samples.  Random numbers are consumed in the
+  // same order as by repeated calls of operator(), and thus the result
+  // is identical, but the table lookup is vectorized if possible.
+  template<class Engine>
+  void generate(Engine& eng, result_type* first, result_type* last) const {
+    generate(eng, first, last, std::integral_constant<bool,
+      std::is_same<CutoffType, double>::value && sizeof(result_type) == 4 &&
+      sizeof(std::pair<CutoffType, result_type>) == 16>());
+  }
+
   template<class CONT>
   bool check(const CONT& weights, RealType tol = 1.0e-10) const {
     return detail::check_table(weights, table_, tol);
   }
 
+  // Save the table to `file' (see table_file.hpp for the format)
+  void save(std::string const& file) const {
+    detail::save_table<CutoffType, result_type>(file, detail::table_kind::walker, 0, table_);
+  }
+  // Map the table saved in `file' into memory without copying
+  void load(std::string const& file, bool verify = true) {
+    detail::load_table<CutoffType, result_type>(file, detail::table_kind::walker, table_, verify);
+  }
+
+  // memory footprint of the table
+  std::size_t table_bytes() const { return sizeof(table_[0]) * table_.size(); }
+
 protected:
   IntType size() const { return table_.size(); }
   RealType cutoff(result_type i) const { return table_[i].first; }
   result_type alias(result_type i) const { return table_[i].second; }
 
 private:
-  std::vector<std::pair<RealType, result_type> > table_; // first element:  cutoff value
-                                                         // second element: alias
+  static constexpr RealType two_m64 = RealType(1) / (RealType(std::uint64_t(1) << 63) * 2);
+
+  template<class Engine>
+  void generate(Engine& eng, result_type* first, result_type* last, std::false_type) const {
+    for (; first != last; ++first) *first = operator()(eng);
+  }
+  template<class Engine>
+  void generate(Engine& eng, result_type* first, result_type* last, std::true_type) const {
+    if (table_.size() >= (std::size_t(1) << 29)) {
+      generate(eng, first, last, std::false_type());
+      return;
+    }
+    const std::size_t block = 256;
+    double u1[block], u2[block];
+    while (first != last) {
+      std::size_t k = std::min<std::size_t>(block, last - first);
+      for (std::size_t i = 0; i < k; ++i) {
+        u1[i] = eng();
+        u2[i] = eng();
+      }
+      detail::lookup_f64(reinterpret_cast<const double*>(table_.data()), double(size()),
+        u1, u2, reinterpret_cast<std::uint32_t*>(first), k);
+      first += k;
+    }
+  }
+
+  typedef std::pair<CutoffType, result_type> entry_type;
+  typedef detail::table_storage<entry_type, typename std::allocator_traits<Allocator>::
+    template rebind_alloc<entry_type> > storage_type;
+  typedef typename storage_type::vector_type table_type;
+  storage_type table_; // first element:  cutoff value
+                       // second element: alias
 };
 
 
@@ -247,24 +673,86 @@ private:
 // optimized integer-based version of Walker algorithm
 //
 
-template<class CutoffType, class IntType, class RealType>
-class random_choice_walker<CutoffType, IntType, RealType,
+template<class CutoffType, class IntType, class RealType, class Allocator>
+class random_choice_walker<CutoffType, IntType, RealType, Allocator,
   typename std::enable_if<std::is_integral<CutoffType>::value>::type> {
 public:
   typedef IntType input_type;
   typedef IntType result_type;
+  typedef detail::ft2009_array<CutoffType, IntType> workspace_type;
 
   random_choice_walker() {}
   template<class CONT>
   random_choice_walker(const CONT& weights) {
-    detail::fill_ft2009(weights, table_);
-    bits_ = 31 - int(std::log(table_.size() - 0.5) / std::log(2.0));
+    table_.fill([&](table_type& t) { detail::fill_ft2009(weights, t); });
+    set_log2_size();
+  }
+  // parallel construction with `nthreads' threads (0: all hardware threads)
+  template<class CONT>
+  random_choice_walker(const CONT& weights, unsigned int nthreads) {
+    table_.fill([&](table_type& t) { detail::fill_hs2019(weights, t, nthreads); });
+    set_log2_size();
+  }
+
+  // Rebuild the table for new `weights' in place.  The table and the
+  // work array, which is shared by the tables of the same type in each
+  // thread, keep their capacities, so that rebuilding with at most as
+  // many weights as before allocates no memory.
+  template<class CONT>
+  void rebuild(const CONT& weights) {
+    static thread_local workspace_type work;
+    rebuild(weights, work);
+  }
+  // the same with a work array owned by the caller, e.g. shared by many tables
+  template<class CONT>
+  void rebuild(const CONT& weights, workspace_type& work) {
+    table_.fill([&](table_type& t) { detail::fill_ft2009(weights, t, work); });
+    set_log2_size();
   }
 
+  // The shifts are derived from the bit width of `Engine' (see
+  // engine_bits), which must be at least log2 of the table size.  The
+  // cutoff is compared with the most significant bits of the second word.
+  // The width is not checked per draw; see check_engine.
   template<class Engine>
   result_type operator()(Engine& eng) const {
-    result_type x = eng() >> bits_;
-    return (eng() < cutoff(x)) ? x : alias(x);
+    constexpr int w = detail::engine_bits<Engine>::value;
+    assert(log2_size_ <= w);
+    result_type x = result_type(std::uint64_t(eng()) >> (w - log2_size_));
+    return detail::below_cutoff<w>(eng(), cutoff(x)) ? x : alias(x);
+  }
+
+  // Sampling with one call of a 64-bit engine (e.g. std::mt19937_64)
+  // instead of two calls of a 32-bit one.  The upper log2(N) bits of the
+  // word select the bin and the following bits are compared with the
+  // cutoff.  Since the two are taken from disjoint bits, the result is
+  // distributed as that of operator(), i.e. the bias is only due to the
+  // resolution of the cutoff values (see table_width), as long as
+  // log2(N) plus the width of CutoffType does not exceed 64.
+  template<class Engine>
+  result_type single_draw(Engine& eng) const {
+    static_assert(detail::is_engine64<Engine>::value, "single_draw requires a 64-bit engine");
+    std::uint64_t w = eng();
+    result_type x = result_type(w >> (64 - log2_size_));
+    return detail::below_cutoff<64>(w << log2_size_, cutoff(x)) ? x : alias(x);
+  }
+
+  // Fill [first, last) with samples.  Random numbers are consumed in the
+  // same order as by repeated calls of operator(), and thus the result
+  // is identical, but the table lookup is vectorized if possible.
+  template<class Engine>
+  void generate(Engine& eng, result_type* first, result_type* last) const {
+    check_engine<Engine>();
+    generate(eng, first, last, std::integral_constant<bool,
+      sizeof(CutoffType) == 4 && sizeof(IntType) == 4 && detail::engine_bits<Engine>::value == 32>());
+  }
+
+  // Throw if the words of `Engine' are too narrow to select a bin of the
+  // table.  Call it once before drawing with operator().
+  template<class Engine>
+  void check_engine() const {
+    if (log2_size_ > detail::engine_bits<Engine>::value)
+      throw std::range_error("random_choice_walker: table larger than engine word");
   }
 
   template<class CONT>
@@ -272,13 +760,336 @@ public:
     return detail::check_table(weights, table_, tol);
   }
 
+  // Save the table to `file' (see table_file.hpp for the format).  The
+  // header parameter is log2 of the table size.
+  void save(std::string const& file) const {
+    detail::save_table<CutoffType, IntType>(file, detail::table_kind::walker, log2_size_, table_);
+  }
+  // Map the table saved in `file' into memory without copying.  The shift
+  // is derived from the table size, and the header parameter must agree
+  // with it, either as log2 of the size or as the former parameter (31 -
+  // log2 of the size), so that older files remain loadable.
+  void load(std::string const& file, bool verify = true) {
+    storage_type table;
+    std::uint64_t param =
+      detail::load_table<CutoffType, IntType>(file, detail::table_kind::walker, table, verify);
+    if (table.size() < 2 || (table.size() & (table.size() - 1)) != 0)
+      throw std::runtime_error("random_choice_walker::load: table size is not a power of two");
+    std::uint64_t l = 0;
+    while ((std::size_t(1) << l) < table.size()) ++l;
+    if (param != l && param != 31 - l)
+      throw std::runtime_error("random_choice_walker::load: header parameter does not match table size in " + file);
+    table_.swap(table);
+    set_log2_size();
+  }
+
+  // memory footprint of the table
+  std::size_t table_bytes() const { return sizeof(table_[0]) * table_.size(); }
+
 protected:
-  IntType cutoff(IntType i) const { return table_[i].first; }
+  CutoffType cutoff(IntType i) const { return table_[i].first; }
   IntType alias(IntType i) const { return table_[i].second; }
 
 private:
-  IntType bits_; // number of bits to be disposed
-  std::vector<std::pair<IntType, IntType> > table_;
+  template<class Engine>
+  void generate(Engine& eng, result_type* first, result_type* last, std::false_type) const {
+    for (; first != last; ++first) *first = operator()(eng);
+  }
+  template<class Engine>
+  void generate(Engine& eng, result_type* first, result_type* last, std::true_type) const {
+    if (log2_size_ > 31) {
+      generate(eng, first, last, std::false_type());
+      return;
+    }
+    const std::size_t block = 256;
+    std::uint32_t r1[block], r2[block];
+    while (first != last) {
+      std::size_t k = std::min<std::size_t>(block, last - first);
+      detail::draw_pairs(eng, r1, r2, k);
+      detail::lookup_u32(reinterpret_cast<const std::uint32_t*>(table_.data()), 32 - log2_size_,
+        r1, r2, reinterpret_cast<std::uint32_t*>(first), k);
+      first += k;
+    }
+  }
+
+  void set_log2_size() {
+    log2_size_ = 0;
+    while ((std::size_t(1) << log2_size_) < table_.size()) ++log2_size_;
+  }
+
+  typedef std::pair<CutoffType, IntType> entry_type;
+  typedef detail::table_storage<entry_type, typename std::allocator_traits<Allocator>::
+    template rebind_alloc<entry_type> > storage_type;
+  typedef typename storage_type::vector_type table_type;
+  int log2_size_; // table size is 2^log2_size_
+  storage_type table_;
+};
+
+
+//
+// double-based Walker algorithm with packed table layout
+//
+// Each bin is represented by a single 64-bit word, the upper 32 bits of
+// which hold the cutoff value in fixed point and the lower 32 bits the
+// alias.  Compared with random_choice_walker<double, ...> (16 bytes per
+// bin, including 4 bytes of padding), the table is halved and every
+// draw touches exactly one aligned word.  The cutoff values are rounded
+// to multiples of 2^-32, i.e. the probability of each bin is biased by
+// at most 2^-32 / N.
+//
+
+template<class IntType = std::uint32_t, class RealType = double>
+class random_choice_packed {
+public:
+  typedef RealType input_type;
+  typedef IntType result_type;
+
+  random_choice_packed() {}
+  template<class CONT>
+  random_choice_packed(const CONT& weights) { init(weights); }
+
+  template<class CONT>
+  void init(const CONT& weights) {
+    static_assert(std::numeric_limits<IntType>::is_integer);
+    static_assert(!std::numeric_limits<RealType>::is_integer);
+    if (weights.size() >= (std::size_t(1) << 32))
+      throw std::range_error("random_choice_packed::init");
+    std::vector<std::pair<RealType, IntType> > table;
+    detail::fill_ft2009(weights, table);
+    table_.resize(table.size());
+    for (std::size_t i = 0; i < table.size(); ++i) {
+      RealType c = std::ldexp(table[i].first, 32);
+      std::uint64_t cutoff = (c < RealType(mask)) ? std::uint64_t(c) : std::uint64_t(mask);
+      table_[i] = (cutoff << 32) | std::uint64_t(table[i].second);
+    }
+  }
+
+  template<class Engine>
+  result_type operator()(Engine& eng) const {
+    result_type x = result_type(RealType(size()) * eng());
+    std::uint64_t w = table_[x];
+    return (eng() < scale * RealType(w >> 32)) ? x : result_type(w & mask);
+  }
+
+  // Sampling with one call of a 64-bit engine (see
+  // random_choice_walker::single_draw).  The probability of each bin is
+  // biased by at most N 2^-64 in addition to the rounding of the cutoff.
+  template<class Engine>
+  result_type single_draw(Engine& eng) const {
+    static_assert(detail::is_engine64<Engine>::value, "single_draw requires a 64-bit engine");
+    std::uint64_t frac;
+    result_type x = result_type(detail::multiply_shift(eng(), size(), frac));
+    std::uint64_t w = table_[x];
+    return ((frac >> 32) < (w >> 32)) ? x : result_type(w & mask);
+  }
+
+  template<class CONT>
+  bool check(const CONT& weights, RealType tol = 1.0e-8) const {
+    std::vector<std::pair<RealType, IntType> > table(table_.size());
+    for (std::size_t i = 0; i < table_.size(); ++i)
+      table[i] = std::make_pair(scale * RealType(table_[i] >> 32), IntType(table_[i] & mask));
+    return detail::check_table(weights, table, tol);
+  }
+
+  // memory footprint of the table
+  std::size_t table_bytes() const { return sizeof(std::uint64_t) * table_.size(); }
+
+protected:
+  IntType size() const { return table_.size(); }
+
+private:
+  static constexpr std::uint64_t mask = 0xffffffffu;
+  static constexpr RealType scale = RealType(1) / RealType(std::uint64_t(1) << 32);
+  std::vector<std::uint64_t> table_; // upper 32 bits: cutoff value
+                                     // lower 32 bits: alias
+};
+
+
+//
+// integer-based Walker algorithm without padding
+//
+// The integral version of fill_ft2009 pads the table to a power of two,
+// so that the bin is given by the upper bits of a random word.  Here the
+// table has exactly N entries, and the bin is obtained by multiply-shift
+// range reduction (see reduce_range) instead.  For N just above a power
+// of two, the table is thus about halved.  The cutoff values are rounded
+// as in random_choice_walker with the same CutoffType.
+//
+
+template<class CutoffType = std::uint32_t, class IntType = std::uint32_t>
+class random_choice_multiply {
+public:
+  typedef IntType input_type;
+  typedef IntType result_type;
+
+  random_choice_multiply() {}
+  template<class CONT>
+  random_choice_multiply(const CONT& weights) { init(weights); }
+
+  template<class CONT>
+  void init(const CONT& weights) {
+    static_assert(std::is_integral<CutoffType>::value, "integer cutoff expected");
+    static_assert(std::numeric_limits<IntType>::is_integer, "integer index expected");
+    if (weights.size() >= (std::size_t(1) << 32))
+      throw std::range_error("random_choice_multiply::init");
+    std::vector<std::pair<double, IntType> > table;
+    detail::fill_ft2009(weights, table);
+    table_.resize(table.size());
+    for (std::size_t i = 0; i < table.size(); ++i)
+      table_[i] = std::make_pair(detail::to_cutoff<CutoffType>(table[i].first), table[i].second);
+  }
+
+  template<class Engine>
+  result_type operator()(Engine& eng) const {
+    result_type x = result_type(detail::reduce_range(eng, table_.size()));
+    return detail::below_cutoff<detail::engine_bits<Engine>::value>(eng(), cutoff(x)) ? x : alias(x);
+  }
+
+  template<class CONT>
+  bool check(const CONT& weights, double tol = 1.0e-10) const {
+    return detail::check_table(weights, table_, tol);
+  }
+
+  // memory footprint of the table
+  std::size_t table_bytes() const { return sizeof(table_[0]) * table_.size(); }
+
+protected:
+  CutoffType cutoff(IntType i) const { return table_[i].first; }
+  IntType alias(IntType i) const { return table_[i].second; }
+
+private:
+  std::vector<std::pair<CutoffType, IntType> > table_;
+};
+
+
+//
+// two-level (blocked) integer-based Walker algorithm
+//
+// The bins are divided into blocks of 2^log2_block bins (512 by default,
+// i.e. a 4 KB page of 8-byte entries).  A top-level table over the
+// total weights of the blocks selects a block, and a table local to the
+// block, whose aliases are offsets within the block, selects the bin.
+// Each draw thus reads one entry of the top-level table, which is
+// 2^log2_block times smaller than a flat table and mostly cached, and one
+// or two entries of the same block, i.e. at most one page of the large
+// table, instead of two random locations.  Three random words are used
+// per draw: the upper bits of the first select the top-level entry and
+// the following ones the entry within the block, and the second and the
+// third are compared with the cutoff values.
+//
+
+template<class CutoffType = std::uint32_t, class IntType = std::uint32_t>
+class random_choice_blocked {
+public:
+  typedef IntType input_type;
+  typedef IntType result_type;
+
+  random_choice_blocked() {}
+  // parallel construction of the blocks with `nthreads' threads (0: all hardware threads)
+  template<class CONT>
+  random_choice_blocked(const CONT& weights, int log2_block = 9, unsigned int nthreads = 1) {
+    init(weights, log2_block, nthreads);
+  }
+
+  template<class CONT>
+  void init(const CONT& weights, int log2_block = 9, unsigned int nthreads = 1) {
+    static_assert(std::is_integral<CutoffType>::value, "integer cutoff expected");
+    static_assert(std::numeric_limits<IntType>::is_integer, "integer index expected");
+    if (weights.size() == 0 || log2_block < 1 || log2_block > 16)
+      throw std::invalid_argument("random_choice_blocked::init");
+    const std::size_t n = weights.size();
+    const std::size_t b = std::size_t(1) << log2_block;
+    const std::size_t nblocks = (n + b - 1) / b;
+    if (nblocks * b - 1 > std::size_t(std::numeric_limits<IntType>::max()))
+      throw std::range_error("random_choice_blocked::init");
+    if (nthreads == 0) nthreads = detail::default_concurrency();
+    nthreads = unsigned(std::min<std::size_t>(nthreads, nblocks));
+    log2_block_ = log2_block;
+
+    std::vector<double> block_weights(nblocks);
+    table_.resize(nblocks * b);
+    detail::parallel_run(nthreads, [&](unsigned int t) {
+      std::vector<double> local(b);
+      ft2009_array<CutoffType, IntType> work;
+      table_type tab;
+      for (std::size_t k = nblocks * t / nthreads; k < nblocks * (t + 1) / nthreads; ++k) {
+        double sum = 0;
+        for (std::size_t j = 0; j < b; ++j) {
+          local[j] = (k * b + j < n) ? double(weights[k * b + j]) : 0;
+          if (local[j] < 0) throw std::invalid_argument("random_choice_blocked::init");
+          sum += local[j];
+        }
+        block_weights[k] = sum;
+        if (sum > 0) {
+          detail::fill_ft2009(local, tab, work);
+          std::copy(tab.begin(), tab.end(), table_.begin() + k * b);
+        } else {
+          // never selected by the top-level table
+          for (std::size_t j = 0; j < b; ++j)
+            table_[k * b + j] = std::make_pair(std::numeric_limits<CutoffType>::max(), IntType(j));
+        }
+      }
+    });
+    detail::fill_ft2009(block_weights, top_);
+    log2_top_ = 0;
+    while ((std::size_t(1) << log2_top_) < top_.size()) ++log2_top_;
+  }
+
+  // The width of `Engine' must be at least log2 of the table size, which
+  // is not checked per draw; see check_engine.
+  template<class Engine>
+  result_type operator()(Engine& eng) const {
+    constexpr int w = detail::engine_bits<Engine>::value;
+    assert(log2_top_ + log2_block_ <= w);
+    std::uint64_t r = eng();
+    std::uint64_t x = r >> (w - log2_top_);
+    std::uint64_t j = (r >> (w - log2_top_ - log2_block_)) & ((std::uint64_t(1) << log2_block_) - 1);
+    std::uint64_t k = detail::below_cutoff<w>(eng(), top_[x].first) ? x : top_[x].second;
+    std::uint64_t base = k << log2_block_;
+    auto const& e = table_[base + j];
+    return result_type(base + (detail::below_cutoff<w>(eng(), e.first) ? j : e.second));
+  }
+
+  // Throw if the words of `Engine' are too narrow to select a bin of the
+  // tables.  Call it once before drawing with operator().
+  template<class Engine>
+  void check_engine() const {
+    if (log2_top_ + log2_block_ > detail::engine_bits<Engine>::value)
+      throw std::range_error("random_choice_blocked: table larger than engine word");
+  }
+
+  // Check the top-level table against the block weights, and the table of
+  // each block with positive weight against the weights in it.  The
+  // default tolerance allows for the rounding of the cutoff values in the
+  // small tables of the blocks (see random_choice_packed).
+  template<class CONT>
+  bool check(const CONT& weights, double tol = 1.0e-8) const {
+    const std::size_t b = std::size_t(1) << log2_block_;
+    std::vector<double> block_weights(table_.size() / b, 0);
+    for (std::size_t i = 0; i < weights.size(); ++i) block_weights[i / b] += weights[i];
+    bool r = detail::check_table(block_weights, top_, tol);
+    std::vector<double> local(b);
+    table_type tab(b);
+    for (std::size_t k = 0; k < block_weights.size(); ++k) {
+      if (block_weights[k] <= 0) continue;
+      for (std::size_t j = 0; j < b; ++j)
+        local[j] = (k * b + j < weights.size()) ? weights[k * b + j] : 0;
+      std::copy(table_.begin() + k * b, table_.begin() + (k + 1) * b, tab.begin());
+      r &= detail::check_table(local, tab, tol);
+    }
+    return r;
+  }
+
+  // memory footprint of the tables
+  std::size_t table_bytes() const { return sizeof(table_[0]) * (table_.size() + top_.size()); }
+  std::size_t top_bytes() const { return sizeof(top_[0]) * top_.size(); }
+
+private:
+  typedef std::vector<std::pair<CutoffType, IntType> > table_type;
+  int log2_block_; // each block has 2^log2_block_ bins
+  int log2_top_;   // top-level table has 2^log2_top_ entries
+  table_type top_;   // (cutoff value, alias block)
+  table_type table_; // (cutoff value, alias offset within the block) of all the blocks
 };
 
 
@@ -286,13 +1097,14 @@ private:
 // random_choice_bsearch (O(log N) algorithm using binary search algorithm)
 //
 
-template<class IntType = unsigned int, class RealType = double>
+template<class IntType = unsigned int, class RealType = double,
+  class Allocator = std::allocator<RealType> >
 class random_choice_bsearch {
 public:
   typedef RealType input_type;
   typedef IntType result_type;
 
-  random_choice_bsearch() : accum_(0) {}
+  random_choice_bsearch() {}
   template<class CONT>
   random_choice_bsearch(CONT const& weights) { init(weights); }
 
@@ -310,20 +1122,31 @@ public:
     }
     if (norm <= RealType(0))
       throw std::invalid_argument("random_choice_bsearch::init");
-    accum_.resize(0);
-    double a = 0;
-    for (auto w : weights) {
-      a += w / norm;
-      accum_.push_back(a);
-    }
+    accum_.fill([&](typename storage_type::vector_type& accum) {
+      accum.resize(0);
+      double a = 0;
+      for (auto w : weights) {
+        a += w / norm;
+        accum.push_back(a);
+      }
+    });
+  }
+
+  // Save the table to `file' (see table_file.hpp for the format)
+  void save(std::string const& file) const {
+    detail::save_table<RealType, void>(file, detail::table_kind::bsearch, 0, accum_);
+  }
+  // Map the table saved in `file' into memory without copying
+  void load(std::string const& file, bool verify = true) {
+    detail::load_table<RealType, void>(file, detail::table_kind::bsearch, accum_, verify);
   }
 
   template<class Engine>
   result_type operator()(Engine& eng) const {
     double p = eng();
-    int first = 0;
-    int last = accum_.size();  // pointing to the next of the last element
-    int current = first + ((last - first) >> 1);
+    std::size_t first = 0;
+    std::size_t last = accum_.size();  // pointing to the next of the last element
+    std::size_t current = first + ((last - first) >> 1);
     if (last - first == 0) {
       return first;
     } else if (last - first == 1) {
@@ -363,8 +1186,134 @@ public:
     }
   }
 
+private:
+  typedef detail::table_storage<RealType, typename std::allocator_traits<Allocator>::
+    template rebind_alloc<RealType> > storage_type;
+  storage_type accum_;
+};
+
+
+//
+// random_choice_eytzinger (O(log N) algorithm with branchless search over
+// the accumulated weights in Eytzinger order)
+//
+
+template<class IntType = unsigned int, class RealType = double>
+class random_choice_eytzinger {
+public:
+  typedef RealType input_type;
+  typedef IntType result_type;
+
+  random_choice_eytzinger() {}
+  template<class CONT>
+  random_choice_eytzinger(CONT const& weights) { init(weights); }
+
+  template<class CONT>
+  void init(CONT const& weights) {
+    static_assert(std::numeric_limits<IntType>::is_integer);
+    static_assert(!std::numeric_limits<RealType>::is_integer);
+    if (weights.size() == 0)
+      throw std::invalid_argument("random_choice_eytzinger::init");
+    RealType norm = 0;
+    for (auto w : weights) {
+      if (w < RealType(0))
+        throw std::invalid_argument("random_choice_eytzinger::init");
+      norm += w;
+    }
+    if (norm <= RealType(0))
+      throw std::invalid_argument("random_choice_eytzinger::init");
+    std::vector<RealType> accum;
+    accum.reserve(weights.size());
+    double a = 0;
+    for (auto w : weights) {
+      a += w / norm;
+      accum.push_back(a);
+    }
+    accum_.init(accum.begin(), accum.end());
+  }
+
+  template<class Engine>
+  result_type operator()(Engine& eng) const { return accum_.upper_bound(eng()); }
+
+private:
+  detail::eytzinger_array<RealType, IntType> accum_;
+};
+
+
+//
+// random_choice_guide (O(1) expected time algorithm with a guide table
+// over the accumulated weights, Chen and Asau 1974)
+//
+// guide_[j] is the first bin whose accumulated weight exceeds j/M, so that
+// the linear search starting there takes less than 1 + N/M steps on
+// average.  The table is built in O(N + M) time.
+//
+
+template<class IntType = unsigned int, class RealType = double>
+class random_choice_guide {
+public:
+  typedef RealType input_type;
+  typedef IntType result_type;
+
+  random_choice_guide() {}
+  template<class CONT>
+  random_choice_guide(CONT const& weights, double factor = 1) { init(weights, factor); }
+
+  // M = factor * N buckets
+  template<class CONT>
+  void init(CONT const& weights, double factor = 1) {
+    static_assert(std::numeric_limits<IntType>::is_integer);
+    static_assert(!std::numeric_limits<RealType>::is_integer);
+    if (weights.size() == 0 || !(factor > 0))
+      throw std::invalid_argument("random_choice_guide::init");
+    if (weights.size() - 1 > std::size_t(std::numeric_limits<IntType>::max()))
+      throw std::range_error("random_choice_guide::init");
+    RealType norm = 0;
+    for (auto w : weights) {
+      if (w < RealType(0))
+        throw std::invalid_argument("random_choice_guide::init");
+      norm += w;
+    }
+    if (norm <= RealType(0))
+      throw std::invalid_argument("random_choice_guide::init");
+    accum_.resize(0);
+    double a = 0;
+    std::size_t last = 0; // last bin with positive weight
+    for (auto w : weights) {
+      if (w > RealType(0)) last = accum_.size();
+      a += w / norm;
+      accum_.push_back(a);
+    }
+    // the search always stops at the last bin with positive weight, even
+    // if rounding errors leave its accumulated weight below one
+    accum_[last] = 2;
+
+    std::size_t m = std::max<std::size_t>(1, std::size_t(factor * weights.size()));
+    // one extra bucket in case u * M is rounded up to M
+    guide_.resize(m + 1);
+    bucket_ = RealType(m);
+    std::size_t i = 0;
+    for (std::size_t j = 0; j <= m; ++j) {
+      while (accum_[i] <= RealType(j) / bucket_) ++i;
+      guide_[j] = IntType(i);
+    }
+  }
+
+  std::size_t size() const { return accum_.size(); }
+  std::size_t buckets() const { return guide_.size() - 1; }
+
+  template<class Engine>
+  result_type operator()(Engine& eng) const {
+    RealType u = eng();
+    std::size_t i = guide_[std::size_t(u * bucket_)];
+    while (accum_[i] <= u) ++i;
+    return result_type(i);
+  }
+
 private:
   std::vector<RealType> accum_;
+  std::vector<IntType> guide_;
+  RealType bucket_; // number of buckets
 };
 
 
@@ -415,46 +1364,121 @@ private:
   std::vector<RealType> accum_;
 };
 
+// table entries for engine `RNG': cutoff values of the engine type
+// itself for real-valued engines, 32-bit cutoff values and indices for
+// integer engines of at most 32 bits, and 64-bit ones for wider engines
+template<class RNG, class Enable = void>
+struct engine_table {
+  typedef typename RNG::result_type cutoff_type;
+  typedef unsigned int index_type;
+};
+
+template<class RNG>
+struct engine_table<RNG, std::enable_if_t<std::is_integral<typename RNG::result_type>::value> > {
+  typedef typename std::conditional<(engine_bits<RNG>::value > 32),
+    std::uint64_t, std::uint32_t>::type cutoff_type;
+  typedef typename std::conditional<(engine_bits<RNG>::value > 32),
+    std::uint64_t, unsigned int>::type index_type;
+};
+
 } // end namespace detail
 
-template<typename RNG>
-class random_choice : public detail::random_choice_walker<typename RNG::result_type, unsigned int, double> {
+//
+// table_width: widths of the cutoff value and the alias of table entries
+//
+// Each entry of a table with M entries carries probability 1/M, a part
+// of which is assigned to the alias according to the cutoff value.  The
+// cutoff values are stored with finite resolution max_bias(), so that
+// each entry misassigns at most max_bias() / M, and the total variation
+// distance between the sampled and the exact distributions is at most
+// max_bias().  Integer cutoffs require an engine returning uniform words
+// of at least log2(M) bits (see engine_bits), the resolution of which
+// also limits max_bias(), floating-point ones an engine returning real
+// numbers in [0,1).
+//
+
+template<class CutoffType, class IndexType>
+struct table_width {
+  typedef CutoffType cutoff_type;
+  typedef IndexType index_type;
+  static constexpr std::size_t entry_bytes() { return sizeof(std::pair<CutoffType, IndexType>); }
+  static constexpr double max_bias() {
+    return std::is_integral<CutoffType>::value ?
+      2 / (double(std::numeric_limits<CutoffType>::max()) + 1) :
+      double(std::numeric_limits<CutoffType>::epsilon()) / 2;
+  }
+};
+
+typedef table_width<std::uint16_t, std::uint16_t> width_u16; // 4 bytes, N <= 2^16, bias 2^-15
+typedef table_width<float, std::uint32_t> width_f32;         // 8 bytes, bias 2^-24
+typedef table_width<std::uint32_t, std::uint32_t> width_u32; // 8 bytes, bias 2^-31 (random_choice<RNG>)
+typedef table_width<double, std::uint32_t> width_f64;        // 16 bytes, bias 2^-53 (random_choice<double>)
+typedef table_width<std::uint64_t, std::uint64_t> width_u64; // 16 bytes, N <= 2^64, bias 2^-63
+                                                             // (random_choice<std::mt19937_64>)
+
+template<class Width>
+class random_choice_compact : public detail::random_choice_walker<typename Width::cutoff_type,
+  typename Width::index_type, double> {
 private:
-  typedef detail::random_choice_walker<typename RNG::result_type, unsigned int, double> base_type;
+  typedef detail::random_choice_walker<typename Width::cutoff_type,
+    typename Width::index_type, double> base_type;
+public:
+  typedef Width width_type;
+  random_choice_compact() : base_type() {}
+  template<class CONT>
+  random_choice_compact(const CONT& weights) : base_type(weights) {}
+  template<class CONT>
+  random_choice_compact(const CONT& weights, unsigned int nthreads) : base_type(weights, nthreads) {}
+};
+
+// The table is allocated by `Allocator' rebound to the table entry
+// (e.g. walker::huge_page_allocator<char>, see allocator.hpp).
+template<typename RNG, class Allocator = std::allocator<char> >
+class random_choice : public detail::random_choice_walker<typename detail::engine_table<RNG>::cutoff_type, typename detail::engine_table<RNG>::index_type, double, Allocator> {
+private:
+  typedef detail::random_choice_walker<typename detail::engine_table<RNG>::cutoff_type, typename detail::engine_table<RNG>::index_type, double, Allocator> base_type;
 public:
   random_choice() : base_type() {}
   template<class CONT>
   random_choice(const CONT& weights) : base_type(weights) {}
+  template<class CONT>
+  random_choice(const CONT& weights, unsigned int nthreads) : base_type(weights, nthreads) {}
 };
 
-template<>
-class random_choice<double> : public detail::random_choice_walker<double, unsigned int, double> {
+template<class Allocator>
+class random_choice<double, Allocator> : public detail::random_choice_walker<double, unsigned int, double, Allocator> {
 private:
-  typedef detail::random_choice_walker<double, unsigned int, double> base_type;
+  typedef detail::random_choice_walker<double, unsigned int, double, Allocator> base_type;
 public:
   random_choice() : base_type() {}
   template<class CONT>
   random_choice(const CONT& weights) : base_type(weights) {}
+  template<class CONT>
+  random_choice(const CONT& weights, unsigned int nthreads) : base_type(weights, nthreads) {}
 };
 
-template<>
-class random_choice<unsigned int> : public detail::random_choice_walker<unsigned int, unsigned int, double> {
+template<class Allocator>
+class random_choice<unsigned int, Allocator> : public detail::random_choice_walker<unsigned int, unsigned int, double, Allocator> {
 private:
-  typedef detail::random_choice_walker<unsigned int, unsigned int, double> base_type;
+  typedef detail::random_choice_walker<unsigned int, unsigned int, double, Allocator> base_type;
 public:
   random_choice() : base_type() {}
   template<class CONT>
   random_choice(const CONT& weights) : base_type(weights) {}
+  template<class CONT>
+  random_choice(const CONT& weights, unsigned int nthreads) : base_type(weights, nthreads) {}
 };
 
-template<>
-class random_choice<long unsigned int> : public detail::random_choice_walker<long unsigned int, unsigned int, double> {
+template<class Allocator>
+class random_choice<long unsigned int, Allocator> : public detail::random_choice_walker<std::uint32_t, unsigned int, double, Allocator> {
 private:
-  typedef detail::random_choice_walker<long unsigned int, unsigned int, double> base_type;
+  typedef detail::random_choice_walker<std::uint32_t, unsigned int, double, Allocator> base_type;
 public:
   random_choice() : base_type() {}
   template<class CONT>
   random_choice(const CONT& weights) : base_type(weights) {}
+  template<class CONT>
+  random_choice(const CONT& weights, unsigned int nthreads) : base_type(weights, nthreads) {}
 };
 
 } // end namespace walker
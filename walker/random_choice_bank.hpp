@@ -0,0 +1,162 @@
+/*
+   Copyright (C) 2022 by Synge Todo <wistaria@phys.s.u-tokyo.ac.jp>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "walker/random_choice.hpp"
+
+namespace walker {
+
+//
+// random_choice_bank: many small integer-based Walker tables in one arena
+//
+// The tables of all the distributions are stored back to back in one
+// contiguous array, each padded to a power of two as in
+// random_choice<RNG>.  The offset of table k and log2 of its size are
+// packed into one 64-bit word meta_[k] (offset << 6 | log2 size), so that
+// bank(k, eng) reads one metadata word and one table entry instead of the
+// size, the data pointer and an entry of a separately allocated vector.
+// The tables are independent, and are built in parallel if requested.
+//
+
+template<class CutoffType = std::uint32_t, class IndexType = std::uint32_t>
+class random_choice_bank {
+public:
+  typedef IndexType result_type;
+  typedef detail::ft2009_array<CutoffType, IndexType> workspace_type;
+  typedef std::vector<std::pair<CutoffType, IndexType> > table_type;
+
+  random_choice_bank() {}
+  // `weights_list' is a random-access container of weight containers, e.g.
+  // std::vector<std::vector<double> >.  The tables are built by `nthreads'
+  // threads (0: all hardware threads).
+  template<class CONTS>
+  random_choice_bank(CONTS const& weights_list, unsigned int nthreads = 1) {
+    init(weights_list, nthreads);
+  }
+
+  template<class CONTS>
+  void init(CONTS const& weights_list, unsigned int nthreads = 1) {
+    static_assert(std::is_integral<CutoffType>::value, "integer cutoff expected");
+    const std::size_t tables = weights_list.size();
+    meta_.resize(tables);
+    std::uint64_t offset = 0;
+    max_log2_size_ = 0;
+    for (std::size_t k = 0; k < tables; ++k) {
+      int l = log2_size(weights_list[k].size());
+      max_log2_size_ = std::max(max_log2_size_, l);
+      meta_[k] = (offset << 6) | std::uint64_t(l);
+      offset += std::uint64_t(1) << l;
+    }
+    if (offset >= (std::uint64_t(1) << 58))
+      throw std::range_error("random_choice_bank::init");
+    arena_.resize(offset);
+    if (nthreads == 0) nthreads = detail::default_concurrency();
+    nthreads = unsigned(std::max<std::size_t>(1, std::min<std::size_t>(nthreads, tables)));
+    detail::parallel_run(nthreads, [&](unsigned int t) {
+      table_type table;
+      workspace_type work;
+      for (std::size_t k = tables * t / nthreads; k < tables * (t + 1) / nthreads; ++k)
+        fill(k, weights_list[k], table, work);
+    });
+  }
+
+  // Rebuild table k for new `weights' in place.  The size of the table,
+  // i.e. the number of weights rounded up to a power of two, must not
+  // change.  No memory is allocated once the work arrays, which are
+  // shared by the banks in each thread, are large enough.
+  template<class CONT>
+  void rebuild(std::size_t k, CONT const& weights) {
+    static thread_local table_type table;
+    static thread_local workspace_type work;
+    rebuild(k, weights, table, work);
+  }
+  // the same with work arrays owned by the caller
+  template<class CONT>
+  void rebuild(std::size_t k, CONT const& weights, table_type& table, workspace_type& work) {
+    if (log2_size(weights.size()) != int(meta_[k] & 63))
+      throw std::invalid_argument("random_choice_bank::rebuild");
+    fill(k, weights, table, work);
+  }
+
+  // number of tables
+  std::size_t size() const { return meta_.size(); }
+  // number of entries of table k
+  std::size_t size(std::size_t k) const { return std::size_t(1) << (meta_[k] & 63); }
+
+  // sample from the k-th distribution (see random_choice_walker::operator())
+  template<class Engine>
+  result_type operator()(std::size_t k, Engine& eng) const {
+    constexpr int w = detail::engine_bits<Engine>::value;
+    const std::uint64_t m = meta_[k];
+    const int l = int(m & 63);
+    assert(l <= w);
+    auto const* table = arena_.data() + (m >> 6);
+    result_type x = result_type(std::uint64_t(eng()) >> (w - l));
+    return detail::below_cutoff<w>(eng(), table[x].first) ? x : table[x].second;
+  }
+
+  // Throw if the words of `Engine' are too narrow to select a bin of the
+  // largest table.  Call it once before drawing with operator().
+  template<class Engine>
+  void check_engine() const {
+    if (max_log2_size_ > detail::engine_bits<Engine>::value)
+      throw std::range_error("random_choice_bank: table larger than engine word");
+  }
+
+  template<class CONT>
+  bool check(std::size_t k, CONT const& weights, double tol = 1.0e-10) const {
+    auto first = arena_.begin() + std::ptrdiff_t(meta_[k] >> 6);
+    table_type table(first, first + std::ptrdiff_t(size(k)));
+    return detail::check_table(weights, table, tol);
+  }
+
+  // memory footprint of the tables and of the metadata
+  std::size_t table_bytes() const {
+    return sizeof(arena_[0]) * arena_.size() + sizeof(meta_[0]) * meta_.size();
+  }
+
+private:
+
+  // log2 of the size of the table for n weights (see fill_ft2009)
+  static int log2_size(std::size_t n) {
+    if (n == 0)
+      throw std::invalid_argument("random_choice_bank");
+    int l = 1;
+    while ((std::size_t(1) << l) < n) ++l;
+    return l;
+  }
+
+  template<class CONT>
+  void fill(std::size_t k, CONT const& weights, table_type& table, workspace_type& work) {
+    detail::fill_ft2009(weights, table, work);
+    std::copy(table.begin(), table.end(), arena_.begin() + std::ptrdiff_t(meta_[k] >> 6));
+  }
+
+  std::vector<std::uint64_t> meta_; // offset << 6 | log2 of the size of each table
+  int max_log2_size_ = 0;           // log2 of the size of the largest table
+  table_type arena_;                // (cutoff value, alias) of all the tables
+};
+
+} // end namespace walker
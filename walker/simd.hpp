@@ -0,0 +1,212 @@
+/*
+   Copyright (C) 2022 by Synge Todo <wistaria@phys.s.u-tokyo.ac.jp>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+# define WALKER_HAVE_X86_SIMD 1
+# include <immintrin.h>
+#endif
+
+namespace walker {
+
+namespace detail {
+
+// Instruction sets used by the batched table lookup.  The kernels are
+// compiled with per-function target attributes, so that the library
+// itself can be built for the baseline architecture and the widest
+// available instruction set is selected at runtime.
+enum class simd_isa { scalar, avx2, avx512 };
+
+inline simd_isa detect_simd_isa() {
+#ifdef WALKER_HAVE_X86_SIMD
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512vl"))
+    return simd_isa::avx512;
+  if (__builtin_cpu_supports("avx2"))
+    return simd_isa::avx2;
+#endif
+  return simd_isa::scalar;
+}
+
+// Currently selected instruction set.  It may be lowered (e.g. in
+// benchmarks), but must not be raised beyond detect_simd_isa().  It is
+// atomic, since it is read by samplers shared among threads.
+inline std::atomic<simd_isa>& simd_level() {
+  static std::atomic<simd_isa> isa(detect_simd_isa());
+  return isa;
+}
+
+//
+// integer table: array of (32-bit cutoff, 32-bit alias) pairs
+//
+
+inline void lookup_u32_scalar(const std::uint32_t* table, unsigned int bits,
+  const std::uint32_t* r1, const std::uint32_t* r2, std::uint32_t* out, std::size_t n) {
+  for (std::size_t i = 0; i < n; ++i) {
+    std::uint32_t x = r1[i] >> bits;
+    out[i] = (r2[i] < table[2 * x]) ? x : table[2 * x + 1];
+  }
+}
+
+#ifdef WALKER_HAVE_X86_SIMD
+
+// The kernels use the masked forms of the intrinsics with all lanes
+// enabled and a zero source, since the unmasked ones pass an undefined
+// source to the builtins, which GCC reports by -Wmaybe-uninitialized.
+
+__attribute__((target("avx2")))
+inline void lookup_u32_avx2(const std::uint32_t* table, unsigned int bits,
+  const std::uint32_t* r1, const std::uint32_t* r2, std::uint32_t* out, std::size_t n) {
+  const int* cut = reinterpret_cast<const int*>(table);
+  const int* ali = cut + 1;
+  const __m128i shift = _mm_cvtsi32_si128(int(bits));
+  const __m256i sign = _mm256_set1_epi32(int(0x80000000u));
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i all = _mm256_set1_epi32(-1);
+  std::size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256i x = _mm256_srl_epi32(
+      _mm256_loadu_si256(reinterpret_cast<const __m256i*>(r1 + i)), shift);
+    __m256i c = _mm256_mask_i32gather_epi32(zero, cut, x, all, 8);
+    __m256i a = _mm256_mask_i32gather_epi32(zero, ali, x, all, 8);
+    __m256i u = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(r2 + i));
+    // unsigned comparison u < c via sign flip
+    __m256i take = _mm256_cmpgt_epi32(_mm256_xor_si256(c, sign), _mm256_xor_si256(u, sign));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_blendv_epi8(a, x, take));
+  }
+  lookup_u32_scalar(table, bits, r1 + i, r2 + i, out + i, n - i);
+}
+
+__attribute__((target("avx512f")))
+inline void lookup_u32_avx512(const std::uint32_t* table, unsigned int bits,
+  const std::uint32_t* r1, const std::uint32_t* r2, std::uint32_t* out, std::size_t n) {
+  const int* cut = reinterpret_cast<const int*>(table);
+  const int* ali = cut + 1;
+  const __m512i shift = _mm512_set1_epi32(int(bits));
+  const __m512i zero = _mm512_setzero_si512();
+  const __mmask16 all = 0xffff;
+  std::size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m512i x = _mm512_maskz_srlv_epi32(all, _mm512_loadu_si512(r1 + i), shift);
+    __m512i c = _mm512_mask_i32gather_epi32(zero, all, x, cut, 8);
+    __m512i a = _mm512_mask_i32gather_epi32(zero, all, x, ali, 8);
+    __mmask16 take = _mm512_cmplt_epu32_mask(_mm512_loadu_si512(r2 + i), c);
+    _mm512_storeu_si512(out + i, _mm512_mask_blend_epi32(take, a, x));
+  }
+  lookup_u32_scalar(table, bits, r1 + i, r2 + i, out + i, n - i);
+}
+
+#endif // WALKER_HAVE_X86_SIMD
+
+// `table' must hold less than 2^31 entries (gather indices are signed).
+inline void lookup_u32(const std::uint32_t* table, unsigned int bits,
+  const std::uint32_t* r1, const std::uint32_t* r2, std::uint32_t* out, std::size_t n) {
+#ifdef WALKER_HAVE_X86_SIMD
+  switch (simd_level().load(std::memory_order_relaxed)) {
+  case simd_isa::avx512:
+    lookup_u32_avx512(table, bits, r1, r2, out, n);
+    return;
+  case simd_isa::avx2:
+    lookup_u32_avx2(table, bits, r1, r2, out, n);
+    return;
+  default:
+    break;
+  }
+#endif
+  lookup_u32_scalar(table, bits, r1, r2, out, n);
+}
+
+//
+// double table: array of (double cutoff, 32-bit alias) pairs with 16-byte stride
+//
+
+inline void lookup_f64_scalar(const double* table, double size,
+  const double* u1, const double* u2, std::uint32_t* out, std::size_t n) {
+  const std::uint32_t* alias = reinterpret_cast<const std::uint32_t*>(table + 1);
+  for (std::size_t i = 0; i < n; ++i) {
+    std::uint32_t x = std::uint32_t(size * u1[i]);
+    out[i] = (u2[i] < table[2 * x]) ? x : alias[4 * x];
+  }
+}
+
+#ifdef WALKER_HAVE_X86_SIMD
+
+__attribute__((target("avx2")))
+inline void lookup_f64_avx2(const double* table, double size,
+  const double* u1, const double* u2, std::uint32_t* out, std::size_t n) {
+  const int* ali = reinterpret_cast<const int*>(table + 1);
+  const __m256d sz = _mm256_set1_pd(size);
+  const __m256i low = _mm256_setr_epi32(0, 2, 4, 6, 0, 0, 0, 0);
+  const __m256d all_pd = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+  const __m128i all_epi32 = _mm_set1_epi32(-1);
+  std::size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    __m128i x = _mm256_cvttpd_epi32(_mm256_mul_pd(_mm256_loadu_pd(u1 + i), sz));
+    __m256d c = _mm256_mask_i32gather_pd(_mm256_setzero_pd(), table, _mm_add_epi32(x, x), all_pd, 8);
+    __m128i a = _mm_mask_i32gather_epi32(_mm_setzero_si128(), ali, _mm_slli_epi32(x, 2), all_epi32, 4);
+    __m256d lt = _mm256_cmp_pd(_mm256_loadu_pd(u2 + i), c, _CMP_LT_OQ);
+    __m128i take = _mm256_castsi256_si128(
+      _mm256_permutevar8x32_epi32(_mm256_castpd_si256(lt), low));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_blendv_epi8(a, x, take));
+  }
+  lookup_f64_scalar(table, size, u1 + i, u2 + i, out + i, n - i);
+}
+
+__attribute__((target("avx512f,avx512vl")))
+inline void lookup_f64_avx512(const double* table, double size,
+  const double* u1, const double* u2, std::uint32_t* out, std::size_t n) {
+  const int* ali = reinterpret_cast<const int*>(table + 1);
+  const __m512d sz = _mm512_set1_pd(size);
+  const __mmask8 all = 0xff;
+  std::size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256i x = _mm512_maskz_cvttpd_epi32(all, _mm512_mul_pd(_mm512_loadu_pd(u1 + i), sz));
+    __m512d c = _mm512_mask_i32gather_pd(_mm512_setzero_pd(), all, _mm256_add_epi32(x, x), table, 8);
+    __m256i a = _mm256_mmask_i32gather_epi32(_mm256_setzero_si256(), all, _mm256_slli_epi32(x, 2), ali, 4);
+    __mmask8 take = _mm512_cmp_pd_mask(_mm512_loadu_pd(u2 + i), c, _CMP_LT_OQ);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_mask_blend_epi32(take, a, x));
+  }
+  lookup_f64_scalar(table, size, u1 + i, u2 + i, out + i, n - i);
+}
+
+#endif // WALKER_HAVE_X86_SIMD
+
+// `table' must hold less than 2^29 entries (gather indices are signed).
+inline void lookup_f64(const double* table, double size,
+  const double* u1, const double* u2, std::uint32_t* out, std::size_t n) {
+#ifdef WALKER_HAVE_X86_SIMD
+  switch (simd_level().load(std::memory_order_relaxed)) {
+  case simd_isa::avx512:
+    lookup_f64_avx512(table, size, u1, u2, out, n);
+    return;
+  case simd_isa::avx2:
+    lookup_f64_avx2(table, size, u1, u2, out, n);
+    return;
+  default:
+    break;
+  }
+#endif
+  lookup_f64_scalar(table, size, u1, u2, out, n);
+}
+
+} // end namespace detail
+
+} // end namespace walker
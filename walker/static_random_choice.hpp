@@ -0,0 +1,137 @@
+/*
+   Copyright (C) 2022 by Synge Todo <wistaria@phys.s.u-tokyo.ac.jp>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#pragma once
+
+#if __cplusplus < 201703L
+# error "walker/static_random_choice.hpp requires C++17 or later"
+#endif
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+#include "walker/random_choice.hpp"
+
+namespace walker {
+
+namespace detail {
+
+// number of table entries (power of two, at least 2) for n bins
+constexpr std::size_t static_table_size(std::size_t n) {
+  std::size_t m = 2;
+  while (m < n) m <<= 1;
+  return m;
+}
+
+constexpr unsigned int static_log2(std::size_t m) {
+  unsigned int k = 0;
+  while ((std::size_t(1) << k) < m) ++k;
+  return k;
+}
+
+} // end namespace detail
+
+//
+// static_random_choice: integer-based Walker algorithm for N bins known at
+// compile time
+//
+// The table is built by a constexpr version of detail::fill_ft2009 (for
+// integer cutoffs), so that a constexpr object holds a table computed
+// at compile time, and the shift for the bin index is a constant.
+//
+
+template<std::size_t N>
+class static_random_choice {
+public:
+  typedef std::uint32_t input_type;
+  typedef unsigned int result_type;
+  typedef std::pair<std::uint32_t, std::uint32_t> entry_type; // (cutoff, alias)
+  static constexpr std::size_t table_size = detail::static_table_size(N);
+  typedef std::array<entry_type, table_size> table_type;
+
+  constexpr explicit static_random_choice(std::array<double, N> const& weights) : table_() {
+    static_assert(N > 0, "static_random_choice requires at least one bin");
+    double norm = 0;
+    for (std::size_t i = 0; i < N; ++i) {
+      if (weights[i] < 0)
+        throw std::invalid_argument("static_random_choice");
+      norm += weights[i];
+    }
+    if (norm <= 0)
+      throw std::invalid_argument("static_random_choice");
+    norm = table_size / norm;
+
+    // Initialize arrays.  We will reorder the elements in `array', so
+    // that all the negative elements precede the positive ones.
+    std::array<double, table_size> b{};
+    std::array<std::uint32_t, table_size> idx{};
+    std::size_t neg_p = 0;
+    std::size_t pos_p = table_size;
+    for (std::size_t i = 0; i < table_size; ++i) {
+      double v = norm * (i < N ? weights[i] : 0) - 1;
+      if (v < 0) {
+        b[neg_p] = v;
+        idx[neg_p] = i;
+        ++neg_p;
+      } else {
+        --pos_p;
+        b[pos_p] = v;
+        idx[pos_p] = i;
+      }
+    }
+
+    // Note: now `pos_p' is pointing the first non-negative element in the array.
+
+    // Assign alias and cutoff values
+    for (neg_p = 0; neg_p != table_size; ++neg_p) {
+      if (pos_p != table_size) {
+        table_[idx[neg_p]].first = detail::to_cutoff<std::uint32_t>(1 + b[neg_p]);
+        table_[idx[neg_p]].second = idx[pos_p];
+        b[pos_p] += b[neg_p];
+        if (b[pos_p] <= 0) ++pos_p;
+      } else {
+        table_[idx[neg_p]].first = detail::to_cutoff<std::uint32_t>(1);
+        table_[idx[neg_p]].second = idx[neg_p];
+      }
+    }
+  }
+
+  // The shift is derived from the bit width of `Engine' (see
+  // detail::engine_bits), which must be at least log2 of the table size.
+  template<class Engine>
+  result_type operator()(Engine& eng) const {
+    constexpr int w = detail::engine_bits<Engine>::value;
+    static_assert(w >= log2_size, "static_random_choice: table larger than engine word");
+    result_type x = result_type(std::uint64_t(eng()) >> (w - log2_size));
+    return detail::below_cutoff<w>(eng(), table_[x].first) ? x : table_[x].second;
+  }
+
+  template<class CONT>
+  bool check(const CONT& weights, double tol = 1.0e-10) const {
+    return detail::check_table(weights, table_, tol);
+  }
+
+  static constexpr std::size_t size() { return N; }
+  constexpr table_type const& table() const { return table_; }
+
+private:
+  static constexpr int log2_size = int(detail::static_log2(table_size)); // log2 of the table size
+  table_type table_;
+};
+
+} // end namespace walker
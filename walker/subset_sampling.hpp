@@ -0,0 +1,250 @@
+/*
+   Copyright (C) 2022 by Synge Todo <wistaria@phys.s.u-tokyo.ac.jp>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include "walker/random_choice.hpp"
+
+namespace walker {
+
+// Weighted sampling of k distinct elements without replacement, i.e. k
+// successive draws each proportional to weight among the elements not yet
+// drawn.  The following algorithms are provided:
+//
+//  sample_tree: draws from a binary tree of partial sums and removes the
+//    drawn element.  Removals are recorded in a per-call hash table of
+//    overridden nodes (or in a copy of the tree if k log N is comparable
+//    to N), so that the shared tree is not modified.  O(k log N).
+//  sample_keys: takes k largest keys log(u)/w (Efraimidis and Spirakis
+//    2006) by partial selection.  O(N + k log k).
+//  operator(): draws from an alias table rejecting duplicates, as long as
+//    the drawn elements carry less than half of the total weight, and then
+//    continues with one of the above.  O(k) for small k.
+//
+// All of them return the elements in the order of the successive draws.
+
+template<class IntType = int>
+class subset_sampling {
+public:
+  typedef IntType result_type;
+  subset_sampling() { const double one = 1.0; init(&one, &one + 1); }
+  template <class InputIterator>
+  subset_sampling(InputIterator firstW, InputIterator lastW) { init(firstW, lastW); }
+
+  template <class InputIterator>
+  void init(InputIterator firstW, InputIterator lastW) {
+    std::vector<double> weights(firstW, lastW);
+    if (weights.size() == 0)
+      throw std::invalid_argument("subset_sampling::init");
+    size_ = weights.size();
+    leaves_ = 1;
+    depth_ = 0;
+    while (leaves_ < size_) {
+      leaves_ <<= 1;
+      ++depth_;
+    }
+    tree_.assign(2 * leaves_, 0.0);
+    positives_ = 0;
+    for (std::size_t i = 0; i < size_; ++i) {
+      if (weights[i] < 0)
+        throw std::invalid_argument("subset_sampling::init");
+      if (weights[i] > 0) ++positives_;
+      tree_[leaves_ + i] = weights[i];
+    }
+    for (std::size_t k = leaves_ - 1; k > 0; --k) tree_[k] = tree_[2 * k] + tree_[2 * k + 1];
+    alias_ = alias_type(weights);
+  }
+
+  std::size_t size() const { return size_; }
+  // number of elements with positive weight, i.e. the largest possible k
+  std::size_t positives() const { return positives_; }
+  double weight(result_type i) const { return tree_[leaves_ + i]; }
+  double sum() const { return tree_[1]; }
+
+  template<class Engine, class OutputIterator>
+  OutputIterator operator()(Engine& eng, std::size_t k, OutputIterator out) const {
+    if (k > positives_)
+      throw std::invalid_argument("subset_sampling");
+    std::uniform_real_distribution<> dist;
+    auto u01 = [&]() { return dist(eng); };
+    std::vector<std::size_t> drawn;
+    drawn.reserve(k);
+    index_set taken(k);
+    double removed = 0;
+    while (drawn.size() < k && removed < 0.5 * sum()) {
+      std::size_t i = alias_(u01);
+      if (taken.insert(i + 1)) {
+        drawn.push_back(i);
+        removed += weight(result_type(i));
+        *out++ = result_type(i);
+      }
+    }
+    if (drawn.size() < k) {
+      if ((k - drawn.size()) * depth_ < size_)
+        out = sample_tree(eng, k - drawn.size(), out, drawn);
+      else
+        out = sample_keys(eng, k - drawn.size(), out, taken);
+    }
+    return out;
+  }
+
+  template<class Engine, class OutputIterator>
+  OutputIterator sample_tree(Engine& eng, std::size_t k, OutputIterator out) const {
+    if (k > positives_)
+      throw std::invalid_argument("subset_sampling::sample_tree");
+    return sample_tree(eng, k, out, std::vector<std::size_t>());
+  }
+
+  template<class Engine, class OutputIterator>
+  OutputIterator sample_keys(Engine& eng, std::size_t k, OutputIterator out) const {
+    if (k > positives_)
+      throw std::invalid_argument("subset_sampling::sample_keys");
+    return sample_keys(eng, k, out, index_set(0));
+  }
+
+private:
+  typedef detail::random_choice_walker<double, std::uint32_t, double> alias_type;
+
+  // set of positive integers by open addressing (0 marks an empty slot)
+  template<class T>
+  class hash_table {
+  public:
+    explicit hash_table(std::size_t n) {
+      std::size_t slots = 4;
+      while (slots < 2 * n) slots <<= 1;
+      mask_ = slots - 1;
+      slots_.assign(slots, std::make_pair(std::size_t(0), T()));
+    }
+    // slot of key `n' (> 0), and whether it has been inserted now
+    std::pair<T*, bool> find(std::size_t n) {
+      std::size_t h = (n * 0x9e3779b97f4a7c15ull) >> 32 & mask_;
+      while (slots_[h].first != n) {
+        if (slots_[h].first == 0) {
+          slots_[h].first = n;
+          return std::make_pair(&slots_[h].second, true);
+        }
+        h = (h + 1) & mask_;
+      }
+      return std::make_pair(&slots_[h].second, false);
+    }
+    bool contains(std::size_t n) const {
+      std::size_t h = (n * 0x9e3779b97f4a7c15ull) >> 32 & mask_;
+      while (slots_[h].first != n) {
+        if (slots_[h].first == 0) return false;
+        h = (h + 1) & mask_;
+      }
+      return true;
+    }
+  private:
+    std::size_t mask_;
+    std::vector<std::pair<std::size_t, T>> slots_;
+  };
+
+  class index_set : public hash_table<char> {
+  public:
+    explicit index_set(std::size_t n) : hash_table<char>(n) {}
+    bool insert(std::size_t n) { return this->find(n).second; }
+  };
+
+  // k successive draws from the partial sums, after removing `drawn'
+  template<class Engine, class OutputIterator>
+  OutputIterator sample_tree(Engine& eng, std::size_t k, OutputIterator out,
+                             std::vector<std::size_t> const& drawn) const {
+    // each draw or removal overrides the nodes on the path to a leaf and
+    // their siblings, i.e. at most 2 * depth + 1 partial sums; hash_table
+    // keeps at least twice as many slots, so that its load stays <= 0.5
+    std::size_t nodes = (k + drawn.size()) * (2 * depth_ + 1);
+    if (4 * nodes < leaves_) {
+      // overridden partial sums
+      hash_table<double> removed(nodes);
+      return descend(eng, k, out, drawn, [&](std::size_t n) -> double& {
+        auto s = removed.find(n);
+        if (s.second) *s.first = tree_[n];
+        return *s.first;
+      });
+    } else {
+      std::vector<double> tree(tree_);
+      return descend(eng, k, out, drawn, [&](std::size_t n) -> double& { return tree[n]; });
+    }
+  }
+
+  template<class Engine, class OutputIterator, class SUM>
+  OutputIterator descend(Engine& eng, std::size_t k, OutputIterator out,
+                         std::vector<std::size_t> const& drawn, SUM&& sum) const {
+    // partial sums are recalculated from their children, so that drawn
+    // elements are removed exactly
+    auto remove = [&](std::size_t n) {
+      sum(n) = 0;
+      for (n >>= 1; n > 0; n >>= 1) sum(n) = sum(2 * n) + sum(2 * n + 1);
+    };
+    for (auto i : drawn) remove(leaves_ + i);
+    std::uniform_real_distribution<> dist;
+    for (std::size_t t = 0; t < k; ++t) {
+      double u = sum(1) * dist(eng);
+      std::size_t n = 1;
+      while (n < leaves_) {
+        n <<= 1;
+        // descend to the right if u exceeds the left subtree, unless the
+        // right subtree is empty (possible only by rounding errors)
+        double left = sum(n);
+        if (u >= left && sum(n + 1) > 0) {
+          u -= left;
+          ++n;
+        }
+      }
+      *out++ = result_type(n - leaves_);
+      remove(n);
+    }
+    return out;
+  }
+
+  // k largest keys among the elements not in `taken' (shifted by one)
+  template<class Engine, class OutputIterator>
+  OutputIterator sample_keys(Engine& eng, std::size_t k, OutputIterator out,
+                             index_set const& taken) const {
+    std::uniform_real_distribution<> dist;
+    std::vector<std::pair<double, result_type>> keys;
+    keys.reserve(positives_);
+    for (std::size_t i = 0; i < size_; ++i) {
+      double w = tree_[leaves_ + i];
+      // log(u) / w with u in (0, 1]
+      if (w > 0 && !taken.contains(i + 1))
+        keys.emplace_back(std::log(1 - dist(eng)) / w, result_type(i));
+    }
+    auto greater = [](std::pair<double, result_type> const& x,
+                      std::pair<double, result_type> const& y) { return x.first > y.first; };
+    if (k < keys.size()) std::nth_element(keys.begin(), keys.begin() + k, keys.end(), greater);
+    std::sort(keys.begin(), keys.begin() + k, greater);
+    for (std::size_t t = 0; t < k; ++t) *out++ = keys[t].second;
+    return out;
+  }
+
+  std::size_t size_;         // number of elements
+  std::size_t leaves_;       // number of leaves (power of two)
+  std::size_t depth_;        // log2(leaves_)
+  std::size_t positives_;    // number of elements with positive weight
+  std::vector<double> tree_; // tree_[1]: root, tree_[leaves_ + i]: weight of i-th element
+  alias_type alias_;         // for the first draws with rejection
+};
+
+}
@@ -0,0 +1,91 @@
+/*
+   Copyright (C) 2022 by Synge Todo <wistaria@phys.s.u-tokyo.ac.jp>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#pragma once
+#include <cstddef>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+namespace walker {
+
+// Sampling from a dynamically changing distribution by using a complete
+// binary tree of partial sums.  Both update of a single weight and
+// sampling take O(log N) time.  Inner nodes are recalculated from their
+// children on every update, so that rounding errors do not accumulate.
+
+template<class IntType = int>
+class sum_tree_sampling {
+public:
+  typedef IntType result_type;
+  sum_tree_sampling() : size_(1), leaves_(1), tree_(2, 1.0) {}
+  template <class InputIterator>
+  sum_tree_sampling(InputIterator firstW, InputIterator lastW) { init(firstW, lastW); }
+
+  template <class InputIterator>
+  void init(InputIterator firstW, InputIterator lastW) {
+    std::vector<double> weights(firstW, lastW);
+    if (weights.size() == 0)
+      throw std::invalid_argument("sum_tree_sampling::init");
+    size_ = weights.size();
+    leaves_ = 1;
+    while (leaves_ < size_) leaves_ <<= 1;
+    tree_.assign(2 * leaves_, 0.0);
+    for (std::size_t i = 0; i < size_; ++i) {
+      if (weights[i] < 0)
+        throw std::invalid_argument("sum_tree_sampling::init");
+      tree_[leaves_ + i] = weights[i];
+    }
+    for (std::size_t k = leaves_ - 1; k > 0; --k) tree_[k] = tree_[2 * k] + tree_[2 * k + 1];
+  }
+
+  // set weight of i-th element to w in O(log N) time
+  void update(result_type i, double w) {
+    if (w < 0)
+      throw std::invalid_argument("sum_tree_sampling::update");
+    std::size_t k = leaves_ + i;
+    tree_[k] = w;
+    for (k >>= 1; k > 0; k >>= 1) tree_[k] = tree_[2 * k] + tree_[2 * k + 1];
+  }
+
+  std::size_t size() const { return size_; }
+  double weight(result_type i) const { return tree_[leaves_ + i]; }
+  double sum() const { return tree_[1]; }
+
+  template<class Engine>
+  result_type operator()(Engine& eng) const {
+    std::uniform_real_distribution<> dist;
+    double u = sum() * dist(eng);
+    std::size_t k = 1;
+    while (k < leaves_) {
+      k <<= 1;
+      // descend to the right if u exceeds the left subtree, unless the
+      // right subtree is empty (possible only by rounding errors)
+      if (u >= tree_[k] && tree_[k + 1] > 0) {
+        u -= tree_[k];
+        ++k;
+      }
+    }
+    return result_type(k - leaves_);
+  }
+
+private:
+  std::size_t size_;        // number of elements
+  std::size_t leaves_;      // number of leaves (power of two)
+  std::vector<double> tree_; // tree_[1]: root, tree_[leaves_ + i]: weight of i-th element
+};
+
+}
@@ -0,0 +1,324 @@
+/*
+   Copyright (C) 2022 by Synge Todo <wistaria@phys.s.u-tokyo.ac.jp>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "walker/table_file.hpp"
+
+namespace walker {
+
+//
+// Streaming construction of Walker tables in bounded memory
+//
+// build_table() reads the weights sequentially from a `source' and writes
+// the table of detail::random_choice_walker<CutoffType, IndexType, ...>
+// to a table file (see table_file.hpp), which is then mapped into memory
+// by load().  Neither the weights nor the table are held in memory: the
+// weights are read three times (once for normalization, and twice by two
+// cursors sweeping over the light and the heavy bins), and the table
+// entries are written in place in the output file.
+//
+// A source provides open(), which returns a reader with `bool next(double&)'
+// that yields the weights from the beginning.  weights_file reads a
+// binary file of native WeightType values, and iterator_source a
+// multi-pass (forward) iterator range.
+//
+
+template<class WeightType = double>
+class weights_file {
+public:
+  explicit weights_file(std::string const& file, std::size_t chunk = 1 << 16)
+    : file_(file), chunk_(chunk ? chunk : 1) {}
+
+  class reader {
+  public:
+    reader(std::string const& file, std::size_t chunk)
+      : is_(file, std::ios::binary), buffer_(chunk), pos_(0), size_(0) {
+      if (!is_)
+        throw std::runtime_error("weights_file: failed to open " + file);
+    }
+    bool next(double& w) {
+      if (pos_ == size_) {
+        is_.read(reinterpret_cast<char*>(buffer_.data()), sizeof(WeightType) * buffer_.size());
+        size_ = std::size_t(is_.gcount()) / sizeof(WeightType);
+        pos_ = 0;
+        if (size_ == 0) return false;
+      }
+      w = double(buffer_[pos_++]);
+      return true;
+    }
+  private:
+    std::ifstream is_;
+    std::vector<WeightType> buffer_;
+    std::size_t pos_, size_;
+  };
+
+  reader open() const { return reader(file_, chunk_); }
+
+private:
+  std::string file_;
+  std::size_t chunk_; // number of weights read at once
+};
+
+template<class ForwardIterator>
+class iterator_source {
+public:
+  iterator_source(ForwardIterator first, ForwardIterator last) : first_(first), last_(last) {}
+  class reader {
+  public:
+    reader(ForwardIterator first, ForwardIterator last) : itr_(first), last_(last) {}
+    bool next(double& w) {
+      if (itr_ == last_) return false;
+      w = double(*itr_++);
+      return true;
+    }
+  private:
+    ForwardIterator itr_, last_;
+  };
+  reader open() const { return reader(first_, last_); }
+private:
+  ForwardIterator first_, last_;
+};
+
+template<class ForwardIterator>
+iterator_source<ForwardIterator> make_iterator_source(ForwardIterator first, ForwardIterator last) {
+  return iterator_source<ForwardIterator>(first, last);
+}
+
+namespace detail {
+
+// Table file whose entries are written in arbitrary order.  The file is
+// mapped into memory if possible, so that only the pages being written
+// are resident.
+template<class CutoffType, class IndexType>
+class table_file_writer {
+public:
+  typedef std::pair<CutoffType, IndexType> entry_type;
+
+  table_file_writer(std::string const& file, table_kind kind, std::uint64_t entries,
+    std::uint64_t param) : file_(file), entries_(entries), addr_(nullptr), bytes_(0) {
+    header_ = make_table_header<CutoffType, IndexType, entry_type>(kind, entries, param);
+    bytes_ = sizeof(table_header) + sizeof(entry_type) * entries;
+#ifdef WALKER_HAVE_MMAP
+    int fd = ::open(file.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+      throw std::runtime_error("table_file_writer: failed to open " + file);
+    if (::ftruncate(fd, off_t(bytes_)) != 0) {
+      ::close(fd);
+      throw std::runtime_error("table_file_writer: failed to resize " + file);
+    }
+    void* addr = ::mmap(nullptr, bytes_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED)
+      throw std::runtime_error("table_file_writer: failed to map " + file);
+    addr_ = static_cast<char*>(addr);
+#else
+    os_.open(file, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!os_)
+      throw std::runtime_error("table_file_writer: failed to open " + file);
+#endif
+  }
+  table_file_writer(const table_file_writer&) = delete;
+  table_file_writer& operator=(const table_file_writer&) = delete;
+  ~table_file_writer() {
+#ifdef WALKER_HAVE_MMAP
+    if (addr_) ::munmap(addr_, bytes_);
+#endif
+  }
+
+  void write(std::uint64_t k, CutoffType cutoff, IndexType alias) {
+    char buf[sizeof(entry_type)];
+    store_entry(buf, entry_type(cutoff, alias));
+#ifdef WALKER_HAVE_MMAP
+    std::memcpy(addr_ + sizeof(table_header) + sizeof(entry_type) * k, buf, sizeof(buf));
+#else
+    os_.seekp(std::streamoff(sizeof(table_header) + sizeof(entry_type) * k));
+    os_.write(buf, sizeof(buf));
+#endif
+  }
+
+  // Write the header with the checksum of all the entries
+  void close() {
+    std::uint64_t h = table_checksum_basis;
+#ifdef WALKER_HAVE_MMAP
+    h = table_checksum(addr_ + sizeof(table_header), sizeof(entry_type) * entries_, h);
+    header_.checksum = h;
+    std::memcpy(addr_, &header_, sizeof(header_));
+    bool ok = ::msync(addr_, bytes_, MS_SYNC) == 0;
+    ::munmap(addr_, bytes_);
+    addr_ = nullptr;
+    if (!ok)
+      throw std::runtime_error("table_file_writer: failed to write " + file_);
+#else
+    std::vector<entry_type> buffer(1 << 12);
+    os_.seekg(std::streamoff(sizeof(table_header)));
+    for (std::uint64_t k = 0; k < entries_; k += buffer.size()) {
+      std::size_t c = std::size_t(std::min<std::uint64_t>(buffer.size(), entries_ - k));
+      os_.read(reinterpret_cast<char*>(buffer.data()), sizeof(entry_type) * c);
+      h = table_checksum(buffer.data(), sizeof(entry_type) * c, h);
+    }
+    header_.checksum = h;
+    os_.seekp(0);
+    os_.write(reinterpret_cast<const char*>(&header_), sizeof(header_));
+    os_.close();
+    if (!os_)
+      throw std::runtime_error("table_file_writer: failed to write " + file_);
+#endif
+  }
+
+private:
+  std::string file_;
+  std::uint64_t entries_;
+  table_header header_;
+  char* addr_;
+  std::size_t bytes_;
+#ifndef WALKER_HAVE_MMAP
+  std::fstream os_;
+#endif
+};
+
+// Sequential scan for the next light (p < 1) or heavy (p >= 1) bin, where
+// p = scale * weight.  Bins from n to m - 1 (padding) have zero weight.
+template<class READER>
+class table_cursor {
+public:
+  table_cursor(READER reader, std::uint64_t n, std::uint64_t m, double scale)
+    : reader_(std::move(reader)), k_(0), n_(n), m_(m), scale_(scale) {}
+  bool next(bool heavy, std::uint64_t& index, double& p) {
+    while (k_ < m_) {
+      double w = 0;
+      if (k_ < n_ && !reader_.next(w))
+        throw std::runtime_error("build_table: source changed while reading");
+      index = k_++;
+      p = scale_ * w;
+      if ((p >= 1) == heavy) return true;
+    }
+    return false;
+  }
+private:
+  READER reader_;
+  std::uint64_t k_, n_, m_;
+  double scale_;
+};
+
+template<class CutoffType, class Enable = void>
+struct stream_cutoff {
+  // floating-point cutoff: probability itself
+  static CutoffType convert(double p) { return CutoffType(std::min(p, 1.0)); }
+};
+
+template<class CutoffType>
+struct stream_cutoff<CutoffType, typename std::enable_if<std::is_integral<CutoffType>::value>::type> {
+  // integer cutoff: fixed point (see to_cutoff in random_choice.hpp)
+  static CutoffType convert(double p) {
+    const double nm = std::numeric_limits<CutoffType>::max();
+    double x = nm * std::min(p, 1.0);
+    return (x < nm) ? CutoffType(x) : std::numeric_limits<CutoffType>::max();
+  }
+};
+
+} // end namespace detail
+
+// Returns the number of table entries.  For integer cutoffs, the table is
+// padded to a power of two as by the integral version of fill_ft2009.
+template<class CutoffType, class IndexType, class SOURCE>
+inline std::uint64_t build_table(SOURCE const& source, std::string const& table_file) {
+  // pass 1: normalization
+  std::uint64_t n = 0;
+  double norm = 0;
+  {
+    auto reader = source.open();
+    double w;
+    while (reader.next(w)) {
+      if (w < 0)
+        throw std::invalid_argument("build_table");
+      norm += w;
+      ++n;
+    }
+  }
+  if (n == 0 || norm <= 0)
+    throw std::invalid_argument("build_table");
+  std::uint64_t m = n;
+  std::uint64_t param = 0;
+  if (std::is_integral<CutoffType>::value) {
+    m = 2;
+    param = 1;
+    while (m < n) {
+      m <<= 1;
+      ++param; // log2 of the table size, see random_choice_walker::save
+    }
+  }
+  if (m - 1 > std::uint64_t(std::numeric_limits<IndexType>::max()))
+    throw std::range_error("build_table");
+  double scale = m / norm;
+
+  // pass 2: sweep of two cursors over the light and the heavy bins
+  typedef detail::stream_cutoff<CutoffType> cutoff;
+  detail::table_file_writer<CutoffType, IndexType> out(table_file, detail::table_kind::walker, m, param);
+  detail::table_cursor<decltype(source.open())> light(source.open(), n, m, scale);
+  detail::table_cursor<decltype(source.open())> heavy(source.open(), n, m, scale);
+  std::uint64_t i, j;
+  double pi, pj;
+  bool has_heavy = heavy.next(true, j, pj);
+  while (light.next(false, i, pi)) {
+    if (!has_heavy) {
+      // possible only by rounding errors
+      out.write(i, cutoff::convert(1), IndexType(i));
+      continue;
+    }
+    out.write(i, cutoff::convert(pi), IndexType(j));
+    pj -= 1 - pi;
+    // the current heavy bin has become light
+    while (pj < 1) {
+      std::uint64_t j2;
+      double p2;
+      if (!heavy.next(true, j2, p2)) {
+        out.write(j, cutoff::convert(1), IndexType(j));
+        has_heavy = false;
+        break;
+      }
+      out.write(j, cutoff::convert(pj), IndexType(j2));
+      p2 -= 1 - pj;
+      j = j2;
+      pj = p2;
+    }
+  }
+  if (has_heavy) {
+    out.write(j, cutoff::convert(1), IndexType(j));
+    while (heavy.next(true, j, pj)) out.write(j, cutoff::convert(1), IndexType(j));
+  }
+  out.close();
+  return m;
+}
+
+template<class CutoffType, class IndexType, class WeightType = double>
+inline std::uint64_t build_table_file(std::string const& weights_file_name,
+  std::string const& table_file, std::size_t chunk = 1 << 16) {
+  return build_table<CutoffType, IndexType>(weights_file<WeightType>(weights_file_name, chunk), table_file);
+}
+
+} // end namespace walker
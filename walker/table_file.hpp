@@ -0,0 +1,247 @@
+/*
+   Copyright (C) 2022 by Synge Todo <wistaria@phys.s.u-tokyo.ac.jp>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include "walker/table_storage.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+# define WALKER_HAVE_MMAP 1
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <unistd.h>
+#endif
+
+namespace walker {
+
+namespace detail {
+
+// On-disk format of sampler tables (native byte order):
+//
+//   offset 0:  table_header (64 bytes)
+//   offset 64: table entries, exactly as stored in memory
+//
+// The header identifies the sampler and the element types, so that a
+// table is never reinterpreted with a different layout, and carries a
+// checksum of the entries.
+
+enum class table_kind : std::uint32_t { walker = 1, bsearch = 2 };
+
+struct table_header {
+  char magic[8];              // "WALKERTB"
+  std::uint32_t byte_order;   // 0x01020304 in native byte order
+  std::uint32_t version;      // format version
+  std::uint32_t kind;         // table_kind
+  std::uint32_t cutoff_size;  // sizeof(cutoff or accumulated weight)
+  std::uint32_t cutoff_float; // 1 for floating-point, 0 for integer
+  std::uint32_t index_size;   // sizeof(index), 0 if not stored
+  std::uint32_t entry_size;   // sizeof(table entry)
+  std::uint32_t reserved;
+  std::uint64_t entries;      // number of table entries
+  std::uint64_t param;        // sampler-specific parameter
+  std::uint64_t checksum;     // checksum of table entries
+};
+static_assert(sizeof(table_header) == 64, "unexpected size of table_header");
+
+static const char table_magic[8] = { 'W', 'A', 'L', 'K', 'E', 'R', 'T', 'B' };
+static const std::uint32_t table_byte_order = 0x01020304;
+static const std::uint32_t table_version = 1;
+
+// FNV-1a hash over 64-bit words (and the remaining bytes).  The hash of
+// consecutive blocks is obtained by passing the hash of the preceding
+// ones as `h', provided that the block sizes are multiples of 8 bytes.
+static const std::uint64_t table_checksum_basis = 0xcbf29ce484222325ull;
+inline std::uint64_t table_checksum(const void* data, std::size_t bytes,
+  std::uint64_t h = table_checksum_basis) {
+  const std::uint64_t prime = 0x100000001b3ull;
+  const unsigned char* p = static_cast<const unsigned char*>(data);
+  std::size_t i = 0;
+  for (; i + 8 <= bytes; i += 8) {
+    std::uint64_t w;
+    std::memcpy(&w, p + i, 8);
+    h = (h ^ w) * prime;
+  }
+  for (; i < bytes; ++i) h = (h ^ p[i]) * prime;
+  return h;
+}
+
+// size of a table field, 0 for absent (void) fields
+template<class T> struct stored_size : std::integral_constant<std::uint32_t, sizeof(T)> {};
+template<> struct stored_size<void> : std::integral_constant<std::uint32_t, 0> {};
+
+template<class CutoffType, class IndexType, class Entry>
+inline table_header make_table_header(table_kind kind, std::uint64_t entries, std::uint64_t param) {
+  table_header h;
+  std::memset(&h, 0, sizeof(h));
+  std::memcpy(h.magic, table_magic, sizeof(h.magic));
+  h.byte_order = table_byte_order;
+  h.version = table_version;
+  h.kind = std::uint32_t(kind);
+  h.cutoff_size = sizeof(CutoffType);
+  h.cutoff_float = std::is_floating_point<CutoffType>::value ? 1 : 0;
+  h.index_size = stored_size<IndexType>::value;
+  h.entry_size = sizeof(Entry);
+  h.entries = entries;
+  h.param = param;
+  return h;
+}
+
+// Store the members of an entry into `buf' of sizeof(entry) bytes, so
+// that the padding bytes, which enter the checksum, are zero
+template<class T>
+inline void store_entry(char* buf, T const& e) { std::memcpy(buf, &e, sizeof(e)); }
+
+template<class T1, class T2>
+inline void store_entry(char* buf, std::pair<T1, T2> const& e) {
+  std::size_t offset = reinterpret_cast<const char*>(&e.second) - reinterpret_cast<const char*>(&e);
+  std::memset(buf, 0, sizeof(e));
+  std::memcpy(buf, &e.first, sizeof(e.first));
+  std::memcpy(buf + offset, &e.second, sizeof(e.second));
+}
+
+template<class CutoffType, class IndexType, class TABLE>
+inline void save_table(std::string const& file, table_kind kind, std::uint64_t param,
+  TABLE const& table) {
+  typedef typename TABLE::value_type entry_type;
+  static_assert(std::is_trivially_copy_constructible<entry_type>::value &&
+    std::is_trivially_destructible<entry_type>::value, "table entries must be plain data");
+  table_header h = make_table_header<CutoffType, IndexType, entry_type>(kind, table.size(), param);
+  std::ofstream os(file, std::ios::binary | std::ios::trunc);
+  os.write(reinterpret_cast<const char*>(&h), sizeof(h));
+  // entries are written in blocks of a multiple of 8 bytes (see table_checksum)
+  const std::size_t block = 4096;
+  std::unique_ptr<char[]> buf(new char[sizeof(entry_type) * block]);
+  std::uint64_t checksum = table_checksum_basis;
+  for (std::size_t k = 0; k < table.size(); k += block) {
+    std::size_t c = std::min(block, table.size() - k);
+    for (std::size_t i = 0; i < c; ++i) store_entry(buf.get() + sizeof(entry_type) * i, table[k + i]);
+    checksum = table_checksum(buf.get(), sizeof(entry_type) * c, checksum);
+    os.write(buf.get(), std::streamsize(sizeof(entry_type) * c));
+  }
+  h.checksum = checksum;
+  os.seekp(0);
+  os.write(reinterpret_cast<const char*>(&h), sizeof(h));
+  if (!os)
+    throw std::runtime_error("save_table: failed to write " + file);
+}
+
+// whether all the aliases point into the table
+template<class IndexType, class Entry>
+inline bool valid_aliases(const Entry*, std::uint64_t, std::true_type) { return true; }
+template<class IndexType, class Entry>
+inline bool valid_aliases(const Entry* data, std::uint64_t entries, std::false_type) {
+  for (std::uint64_t k = 0; k < entries; ++k)
+    if (std::uint64_t(data[k].second) >= entries) return false;
+  return true;
+}
+
+// Read-only memory image of a whole file
+class mapped_file {
+public:
+  explicit mapped_file(std::string const& file) : addr_(nullptr), size_(0) {
+#ifdef WALKER_HAVE_MMAP
+    int fd = ::open(file.c_str(), O_RDONLY);
+    if (fd < 0)
+      throw std::runtime_error("mapped_file: failed to open " + file);
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || st.st_size == 0) {
+      ::close(fd);
+      throw std::runtime_error("mapped_file: failed to stat " + file);
+    }
+    size_ = std::size_t(st.st_size);
+    void* addr = ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED)
+      throw std::runtime_error("mapped_file: failed to map " + file);
+    addr_ = addr;
+#else
+    std::ifstream is(file, std::ios::binary | std::ios::ate);
+    if (!is)
+      throw std::runtime_error("mapped_file: failed to open " + file);
+    size_ = std::size_t(is.tellg());
+    buffer_.reset(new std::uint64_t[(size_ + 7) / 8]);
+    is.seekg(0);
+    is.read(reinterpret_cast<char*>(buffer_.get()), size_);
+    if (!is)
+      throw std::runtime_error("mapped_file: failed to read " + file);
+    addr_ = buffer_.get();
+#endif
+  }
+  mapped_file(const mapped_file&) = delete;
+  mapped_file& operator=(const mapped_file&) = delete;
+  ~mapped_file() {
+#ifdef WALKER_HAVE_MMAP
+    if (addr_) ::munmap(addr_, size_);
+#endif
+  }
+  const void* data() const { return addr_; }
+  std::size_t size() const { return size_; }
+
+private:
+  void* addr_;
+  std::size_t size_;
+#ifndef WALKER_HAVE_MMAP
+  std::unique_ptr<std::uint64_t[]> buffer_;
+#endif
+};
+
+// Map a table file and let `table' refer to its entries without copying.
+// Returns the sampler-specific parameter stored in the header.  The
+// aliases are always checked to be within the table, also if `verify'
+// is false and the checksum is not computed, since an alias out of range
+// would be read beyond the table on sampling.
+template<class CutoffType, class IndexType, class Entry, class Allocator>
+inline std::uint64_t load_table(std::string const& file, table_kind kind,
+  table_storage<Entry, Allocator>& table, bool verify = true) {
+  auto image = std::make_shared<mapped_file>(file);
+  if (image->size() < sizeof(table_header))
+    throw std::runtime_error("load_table: " + file + " is not a table file");
+  table_header h;
+  std::memcpy(&h, image->data(), sizeof(h));
+  if (std::memcmp(h.magic, table_magic, sizeof(h.magic)) != 0)
+    throw std::runtime_error("load_table: " + file + " is not a table file");
+  if (h.byte_order != table_byte_order || h.version != table_version)
+    throw std::runtime_error("load_table: unsupported format of " + file);
+  table_header expected = make_table_header<CutoffType, IndexType, Entry>(kind, h.entries, h.param);
+  if (h.kind != expected.kind || h.cutoff_size != expected.cutoff_size ||
+      h.cutoff_float != expected.cutoff_float || h.index_size != expected.index_size ||
+      h.entry_size != expected.entry_size)
+    throw std::runtime_error("load_table: type mismatch in " + file);
+  // h.entries * sizeof(Entry) may overflow for a corrupted header
+  if (h.entries == 0 || h.entries > (image->size() - sizeof(h)) / sizeof(Entry))
+    throw std::runtime_error("load_table: " + file + " is truncated");
+  const Entry* data = reinterpret_cast<const Entry*>(
+    static_cast<const char*>(image->data()) + sizeof(h));
+  if (verify && table_checksum(data, sizeof(Entry) * h.entries) != h.checksum)
+    throw std::runtime_error("load_table: checksum mismatch in " + file);
+  if (!valid_aliases<IndexType>(data, h.entries, std::is_void<IndexType>()))
+    throw std::runtime_error("load_table: alias out of range in " + file);
+  table.assign_view(data, h.entries, image);
+  return h.param;
+}
+
+} // end namespace detail
+
+} // end namespace walker
@@ -0,0 +1,101 @@
+/*
+   Copyright (C) 2022 by Synge Todo <wistaria@phys.s.u-tokyo.ac.jp>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace walker {
+
+namespace detail {
+
+// Read-only table used by the samplers.  The elements are either owned
+// (stored in a std::vector) or a non-owning view of external memory,
+// e.g. a memory-mapped file, which is kept alive by a shared pointer.
+// The owned vector is allocated by `Allocator' (see allocator.hpp).
+
+template<class T, class Allocator = std::allocator<T> >
+class table_storage {
+public:
+  typedef T value_type;
+  typedef Allocator allocator_type;
+  typedef std::vector<T, Allocator> vector_type;
+
+  table_storage() : data_(nullptr), size_(0) {}
+  table_storage(const table_storage& other) : vec_(other.vec_), owner_(other.owner_) {
+    data_ = owner_ ? other.data_ : vec_.data();
+    size_ = other.size_;
+  }
+  table_storage(table_storage&& other) noexcept : table_storage() { swap(other); }
+  table_storage& operator=(table_storage other) noexcept {
+    swap(other);
+    return *this;
+  }
+  void swap(table_storage& other) noexcept {
+    // vector::swap keeps the addresses of the elements valid
+    vec_.swap(other.vec_);
+    owner_.swap(other.owner_);
+    std::swap(data_, other.data_);
+    std::swap(size_, other.size_);
+  }
+
+  // Fill the owned vector by calling f(vector_type&), releasing the view if
+  // any.  If f throws, a view is kept and an owned table is re-pointed to
+  // the vector, so that the storage never refers to released memory.
+  template<class FUNC>
+  void fill(FUNC const& f) {
+    try {
+      f(vec_);
+    } catch (...) {
+      if (!owner_) {
+        data_ = vec_.data();
+        size_ = vec_.size();
+      }
+      throw;
+    }
+    owner_.reset();
+    data_ = vec_.data();
+    size_ = vec_.size();
+  }
+
+  // Use external memory of `size' elements kept alive by `owner'
+  void assign_view(const T* data, std::size_t size, std::shared_ptr<const void> owner) {
+    vector_type().swap(vec_);
+    owner_ = std::move(owner);
+    data_ = data;
+    size_ = size;
+  }
+
+  bool is_view() const { return bool(owner_); }
+  std::size_t size() const { return size_; }
+  const T* data() const { return data_; }
+  const T* begin() const { return data_; }
+  const T* end() const { return data_ + size_; }
+  const T& operator[](std::size_t i) const { return data_[i]; }
+
+private:
+  vector_type vec_;
+  std::shared_ptr<const void> owner_;
+  const T* data_;
+  std::size_t size_;
+};
+
+} // end namespace detail
+
+} // end namespace walker
@@ -15,34 +15,45 @@
 */
 
 #pragma once
-#include <algorithm>
+#include <memory>
+#include <numeric>
+#include <random>
 #include <vector>
+#include "walker/allocator.hpp"
+#include "walker/eytzinger.hpp"
 
 namespace walker {
 
-template<class IntType = int> 
+// The cumulative weights are allocated by `Allocator' (see allocator.hpp).
+template<class IntType = int, class Allocator = std::allocator<double> >
 class tower_sampling {
 public:
   typedef IntType result_type;
-  tower_sampling() : sum_(1.0), table_(1, 1.0) {}
+  tower_sampling() : sum_(1.0) {
+    const double one = 1.0;
+    table_.init(&one, &one + 1);
+  }
   template <class InputIterator>
-  tower_sampling(InputIterator firstW, InputIterator lastW) : table_(0) {
+  tower_sampling(InputIterator firstW, InputIterator lastW) {
     sum_ = std::accumulate(firstW, lastW, 0.0);
+    std::vector<double> accum;
     double s = 0.0;
     for (auto itr = firstW; itr != lastW; ++itr) {
       s += *itr;
-      table_.push_back(s / sum_);
+      accum.push_back(s / sum_);
     }
+    table_.init(accum.begin(), accum.end());
   }
   template<class Engine>
   result_type operator()(Engine& eng) const {
-    auto itr = std::upper_bound(table_.begin(), table_.end(), dist_(eng));
-    return result_type(itr - table_.begin());
+    // the distribution is stateless, and is constructed per call so that
+    // one instance can be shared among threads
+    std::uniform_real_distribution<> dist;
+    return table_.upper_bound(dist(eng));
   }
 private:
-  mutable std::uniform_real_distribution<> dist_;
   double sum_;
-  std::vector<double> table_;
+  detail::eytzinger_array<double, IntType, Allocator> table_; // cumulative weights
 };
 
 }
@@ -0,0 +1,254 @@
+/*
+   Copyright (C) 2022 by Synge Todo <wistaria@phys.s.u-tokyo.ac.jp>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include "walker/simd.hpp"
+
+namespace walker {
+
+namespace detail {
+
+// xoshiro256++ of D. Blackman and S. Vigna, ACM Trans. Math. Software 47,
+// 36 (2021): one step of the state `s', returning a 64-bit word
+inline std::uint64_t rotl64(std::uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+inline std::uint64_t xoshiro256pp_next(std::uint64_t* s) {
+  std::uint64_t r = rotl64(s[0] + s[3], 23) + s[0];
+  std::uint64_t t = s[1] << 17;
+  s[2] ^= s[0];
+  s[3] ^= s[1];
+  s[1] ^= s[2];
+  s[0] ^= s[3];
+  s[2] ^= t;
+  s[3] = rotl64(s[3], 45);
+  return r;
+}
+
+// Advance `s' by 2^128 steps
+inline void xoshiro256_jump(std::uint64_t* s) {
+  static const std::uint64_t jump[4] = { 0x180ec6d33cfd0abaull, 0xd5a61266f0c9392cull,
+                                         0xa9582618e03fc9aaull, 0x39abdc4529b1661cull };
+  std::uint64_t t[4] = { 0, 0, 0, 0 };
+  for (int i = 0; i < 4; ++i)
+    for (int b = 0; b < 64; ++b) {
+      if (jump[i] & (std::uint64_t(1) << b))
+        for (int k = 0; k < 4; ++k) t[k] ^= s[k];
+      xoshiro256pp_next(s);
+    }
+  std::copy(t, t + 4, s);
+}
+
+inline std::uint64_t splitmix64(std::uint64_t& x) {
+  std::uint64_t z = (x += 0x9e3779b97f4a7c15ull);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+  return z ^ (z >> 31);
+}
+
+// `steps' steps of eight xoshiro256++ generators, whose states are
+// s[k][0], ..., s[k][7] (k = 0, ..., 3).  Each step writes the eight
+// 64-bit results in the order of the lanes, each as its lower and upper
+// 32-bit halves, i.e. 16 words.
+inline void xoshiro256pp_x8_scalar(std::uint64_t (*s)[8], std::uint32_t* out, std::size_t steps) {
+  for (std::size_t i = 0; i < steps; ++i)
+    for (int l = 0; l < 8; ++l, out += 2) {
+      std::uint64_t st[4] = { s[0][l], s[1][l], s[2][l], s[3][l] };
+      std::uint64_t r = xoshiro256pp_next(st);
+      for (int k = 0; k < 4; ++k) s[k][l] = st[k];
+      out[0] = std::uint32_t(r);
+      out[1] = std::uint32_t(r >> 32);
+    }
+}
+
+#ifdef WALKER_HAVE_X86_SIMD
+
+__attribute__((target("avx2")))
+inline __m256i rotl64_avx2(__m256i x, int k) {
+  return _mm256_or_si256(_mm256_slli_epi64(x, k), _mm256_srli_epi64(x, 64 - k));
+}
+
+__attribute__((target("avx2")))
+inline void xoshiro256pp_x8_avx2(std::uint64_t (*s)[8], std::uint32_t* out, std::size_t steps) {
+  __m256i s0[2], s1[2], s2[2], s3[2];
+  for (int h = 0; h < 2; ++h) {
+    s0[h] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s[0] + 4 * h));
+    s1[h] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s[1] + 4 * h));
+    s2[h] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s[2] + 4 * h));
+    s3[h] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s[3] + 4 * h));
+  }
+  for (std::size_t i = 0; i < steps; ++i, out += 16)
+    for (int h = 0; h < 2; ++h) {
+      __m256i r = _mm256_add_epi64(rotl64_avx2(_mm256_add_epi64(s0[h], s3[h]), 23), s0[h]);
+      __m256i t = _mm256_slli_epi64(s1[h], 17);
+      s2[h] = _mm256_xor_si256(s2[h], s0[h]);
+      s3[h] = _mm256_xor_si256(s3[h], s1[h]);
+      s1[h] = _mm256_xor_si256(s1[h], s2[h]);
+      s0[h] = _mm256_xor_si256(s0[h], s3[h]);
+      s2[h] = _mm256_xor_si256(s2[h], t);
+      s3[h] = rotl64_avx2(s3[h], 45);
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 8 * h), r);
+    }
+  for (int h = 0; h < 2; ++h) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(s[0] + 4 * h), s0[h]);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(s[1] + 4 * h), s1[h]);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(s[2] + 4 * h), s2[h]);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(s[3] + 4 * h), s3[h]);
+  }
+}
+
+__attribute__((target("avx512f")))
+inline void xoshiro256pp_x8_avx512(std::uint64_t (*s)[8], std::uint32_t* out, std::size_t steps) {
+  __m512i s0 = _mm512_loadu_si512(s[0]);
+  __m512i s1 = _mm512_loadu_si512(s[1]);
+  __m512i s2 = _mm512_loadu_si512(s[2]);
+  __m512i s3 = _mm512_loadu_si512(s[3]);
+  // masked forms, since the unmasked ones trigger -Wmaybe-uninitialized (see simd.hpp)
+  const __mmask8 all = 0xff;
+  for (std::size_t i = 0; i < steps; ++i, out += 16) {
+    __m512i r = _mm512_add_epi64(_mm512_maskz_rol_epi64(all, _mm512_add_epi64(s0, s3), 23), s0);
+    __m512i t = _mm512_maskz_slli_epi64(all, s1, 17);
+    s2 = _mm512_xor_si512(s2, s0);
+    s3 = _mm512_xor_si512(s3, s1);
+    s1 = _mm512_xor_si512(s1, s2);
+    s0 = _mm512_xor_si512(s0, s3);
+    s2 = _mm512_xor_si512(s2, t);
+    s3 = _mm512_maskz_rol_epi64(all, s3, 45);
+    _mm512_storeu_si512(out, r);
+  }
+  _mm512_storeu_si512(s[0], s0);
+  _mm512_storeu_si512(s[1], s1);
+  _mm512_storeu_si512(s[2], s2);
+  _mm512_storeu_si512(s[3], s3);
+}
+
+#endif // WALKER_HAVE_X86_SIMD
+
+// The SIMD kernels store the 64-bit results as they are, which coincides
+// with the order of the scalar one on (little-endian) x86.
+inline void xoshiro256pp_x8(std::uint64_t (*s)[8], std::uint32_t* out, std::size_t steps) {
+#ifdef WALKER_HAVE_X86_SIMD
+  switch (simd_level().load(std::memory_order_relaxed)) {
+  case simd_isa::avx512:
+    xoshiro256pp_x8_avx512(s, out, steps);
+    return;
+  case simd_isa::avx2:
+    xoshiro256pp_x8_avx2(s, out, steps);
+    return;
+  default:
+    break;
+  }
+#endif
+  xoshiro256pp_x8_scalar(s, out, steps);
+}
+
+} // end namespace detail
+
+//
+// xoshiro256pp_x8: eight interleaved xoshiro256++ generators
+//
+// A block generator, which writes `block_words' 32-bit words per step by
+// generate(out, steps).  Lane l starts from the state given by splitmix64
+// of the seed advanced by l 2^128 steps (see xoshiro256_jump), so that the
+// lanes are non-overlapping subsequences of one xoshiro256++ sequence.
+// The eight lanes are advanced together with AVX2 or AVX-512 (see
+// simd_level), and the words do not depend on the instruction set.
+//
+
+class xoshiro256pp_x8 {
+public:
+  typedef std::uint32_t result_type;
+  static constexpr std::size_t block_words = 16;
+  static constexpr std::uint64_t default_seed = 29411;
+
+  explicit xoshiro256pp_x8(std::uint64_t s = default_seed) { seed(s); }
+  void seed(std::uint64_t s = default_seed) {
+    std::uint64_t st[4];
+    for (int k = 0; k < 4; ++k) st[k] = detail::splitmix64(s);
+    for (int l = 0; l < 8; ++l) {
+      for (int k = 0; k < 4; ++k) state_[k][l] = st[k];
+      detail::xoshiro256_jump(st);
+    }
+  }
+
+  void generate(result_type* out, std::size_t steps) { detail::xoshiro256pp_x8(state_, out, steps); }
+
+private:
+  alignas(64) std::uint64_t state_[4][8];
+};
+
+//
+// buffered_engine: engine returning the words of a block generator
+//
+// The words are generated `Steps' steps (Steps * Generator::block_words
+// words) at a time into a buffer, from which operator() returns them one
+// by one.  fill() returns the same words as repeated calls of operator(),
+// but writes whole steps directly to the output.  The batched sampling of
+// the walker samplers (generate) uses fill().
+//
+
+template<class Generator, std::size_t Steps = 32>
+class buffered_engine {
+public:
+  typedef typename Generator::result_type result_type;
+  typedef Generator generator_type;
+  static constexpr std::size_t buffer_size = Steps * Generator::block_words;
+
+  explicit buffered_engine(std::uint64_t s = Generator::default_seed) : gen_(s), pos_(buffer_size) {}
+  void seed(std::uint64_t s = Generator::default_seed) {
+    gen_.seed(s);
+    pos_ = buffer_size;
+  }
+
+  static constexpr result_type min() { return 0; }
+  static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+  result_type operator()() {
+    if (pos_ == buffer_size) {
+      gen_.generate(buffer_, Steps);
+      pos_ = 0;
+    }
+    return buffer_[pos_++];
+  }
+
+  // Fill [first, last) with the next last - first words
+  void fill(result_type* first, result_type* last) {
+    std::size_t k = std::min<std::size_t>(buffer_size - pos_, last - first);
+    first = std::copy(buffer_ + pos_, buffer_ + pos_ + k, first);
+    pos_ += k;
+    std::size_t steps = std::size_t(last - first) / Generator::block_words;
+    gen_.generate(first, steps);
+    for (first += steps * Generator::block_words; first != last; ++first) *first = operator()();
+  }
+
+  void discard(unsigned long long z) {
+    for (; z > 0; --z) operator()();
+  }
+
+private:
+  Generator gen_;
+  std::size_t pos_; // next word in buffer_
+  alignas(64) result_type buffer_[buffer_size];
+};
+
+// SIMD xoshiro256++ engine returning 32-bit words from a buffer of 512 words
+typedef buffered_engine<xoshiro256pp_x8> xoshiro256pp_simd;
+
+} // end namespace walker